@@ -0,0 +1,108 @@
+-- A bundle holds the precompiled bytecode of every module under data/, so
+-- startup reads one file instead of searching package.path for each module
+-- and parsing its source. The bundle's loader goes before the usual
+-- searchers; a module whose source changed since the bundle was built, or
+-- is gone, or whose bytecode does not load, is left to them.
+--
+-- Layout: MAGIC, then one line per module
+-- "name<TAB>path<TAB>mtime<TAB>source size<TAB>bytecode size" and an empty
+-- line, then the bytecode of the modules in the same order.
+local bundle = {}
+
+local MAGIC = "LITEBUNDLE2\n"
+
+
+local function collect(dir, prefix, modules)
+  for _, name in ipairs(system.list_dir(dir) or {}) do
+    local path = dir .. PATHSEP .. name
+    local info = system.get_file_info(path)
+    if info and info.type == "dir" then
+      collect(path, prefix .. name .. ".", modules)
+    elseif info and name:match("%.lua$") then
+      local modname = prefix .. name:gsub("%.lua$", "")
+      modname = modname:gsub("%.init$", "")
+      table.insert(modules, {
+        name = modname, path = path, mtime = info.modified, source_size = info.size
+      })
+    end
+  end
+end
+
+
+-- compiles every module under `dir` into the bundle `filename`; returns the
+-- number of modules
+function bundle.build(dir, filename)
+  local modules = {}
+  collect(dir, "", modules)
+  table.sort(modules, function(a, b) return a.name < b.name end)
+
+  local index, code = {}, {}
+  for _, mod in ipairs(modules) do
+    -- debug info is kept, so errors still name the source file and line
+    local fn = assert(loadfile(mod.path))
+    local dump = string.dump(fn)
+    table.insert(index, string.format("%s\t%s\t%d\t%d\t%d\n",
+      mod.name, mod.path, mod.mtime, mod.source_size, #dump))
+    table.insert(code, dump)
+  end
+
+  local fp = assert( io.open(filename, "wb") )
+  fp:write(MAGIC, table.concat(index), "\n", table.concat(code))
+  fp:close()
+  return #modules
+end
+
+
+-- puts the loader of the bundle `filename` before the usual searchers;
+-- returns false if there is no usable bundle
+function bundle.install(filename)
+  local fp = io.open(filename, "rb")
+  if not fp then return false end
+  local data = fp:read("*a")
+  fp:close()
+  if data:sub(1, #MAGIC) ~= MAGIC then return false end
+
+  local entries = {}
+  local pos = #MAGIC + 1
+  while true do
+    local line_end = data:find("\n", pos, true)
+    if not line_end then return false end
+    local line = data:sub(pos, line_end - 1)
+    pos = line_end + 1
+    if line == "" then break end
+    local name, path, mtime, source_size, size =
+      line:match("^(.-)\t(.-)\t(%d+)\t(%d+)\t(%d+)$")
+    if not name then return false end
+    table.insert(entries, {
+      name = name, path = path, mtime = tonumber(mtime),
+      source_size = tonumber(source_size), size = tonumber(size)
+    })
+  end
+
+  local modules = {}
+  local offset = pos
+  for _, entry in ipairs(entries) do
+    entry.offset = offset
+    offset = offset + entry.size
+    modules[entry.name] = entry
+  end
+
+  local function loader(name)
+    local entry = modules[name]
+    if not entry then return end
+    -- any mtime change counts, so restoring an older file is caught, and
+    -- the size catches most edits within the mtime's one-second resolution
+    local info = system.get_file_info(entry.path)
+    if not info or info.modified ~= entry.mtime or info.size ~= entry.source_size then
+      return
+    end
+    local code = data:sub(entry.offset, entry.offset + entry.size - 1)
+    return (loadstring(code, "@" .. entry.path))
+  end
+
+  table.insert(package.loaders, 2, loader)
+  return true
+end
+
+
+return bundle
@@ -1,12 +1,28 @@
 local core = require "core"
 local common = require "core.common"
 local command = require "core.command"
+local config = require "core.config"
 local keymap = require "core.keymap"
+local style = require "core.style"
+local gc = require "core.gc"
 local LogView = require "core.logview"
 
 
 local fullscreen = false
 
+local project_file_session
+local last_project_files
+
+-- the session keeps the survivors of each typed prefix, so it is only
+-- rebuilt when the project files change
+local function get_project_file_session()
+  if core.project_files ~= last_project_files then
+    project_file_session = core.project_files:new_fuzzy_session()
+    last_project_files = core.project_files
+  end
+  return project_file_session
+end
+
 command.add(nil, {
   ["core:quit"] = function()
     core.quit()
@@ -22,27 +38,28 @@ command.add(nil, {
   end,
 
   ["core:reload-module"] = function()
+    local items = {}
+    for name in pairs(package.loaded) do
+      table.insert(items, name)
+    end
+    local session = system.fuzzy_session.new(items)
     core.command_view:enter("Reload Module", function(text, item)
       local text = item and item.text or text
       core.reload_module(text)
       core.log("Reloaded module %q", text)
     end, function(text)
-      local items = {}
-      for name in pairs(package.loaded) do
-        table.insert(items, name)
-      end
-      return common.fuzzy_match(items, text)
+      return (session:filter(text))
     end)
   end,
 
   ["core:command-finder"] = function()
-    local commands = command.get_all_valid()
+    local session = system.fuzzy_session.new(command.get_all_valid())
     core.command_view:enter("Do Command", function(text, item)
       if item then
         command.perform(item.command)
       end
     end, function(text)
-      local res = common.fuzzy_match(commands, text)
+      local res = session:filter(text)
       for i, name in ipairs(res) do
         res[i] = {
           text = command.prettify_name(name),
@@ -59,16 +76,108 @@ command.add(nil, {
       text = core.project_dir .. PATHSEP .. (item and item.text or text)
       core.root_view:open_doc(core.open_doc(text))
     end, function(text)
-      local files = {}
-      for _, item in pairs(core.project_files) do
-        if item.type == "file" then
-          table.insert(files, item.filename:sub(#core.project_dir + 2))
-        end
+      return (get_project_file_session():filter(text, config.max_suggestions))
+    end)
+  end,
+
+  ["core:find-symbol"] = function()
+    if not core.project_symbols then
+      core.error("Project symbols are not indexed")
+      return
+    end
+    core.command_view:enter("Go To Symbol", function(text, item)
+      if not item then return end
+      local filename = core.project_dir .. PATHSEP .. item.filename
+      local dv = core.root_view:open_doc(core.open_doc(filename))
+      dv.doc:set_selection(item.line, 1)
+      dv:scroll_to_line(item.line, true)
+    end, function(text)
+      local res = core.project_symbols:find_definitions(text, config.max_suggestions)
+      for _, def in ipairs(res) do
+        def.text = def.name
+        def.info = def.filename .. ":" .. def.line
       end
-      return common.fuzzy_match(files, text)
+      return res
     end)
   end,
 
+  ["core:dump-input-latency"] = function()
+    local filename = EXEDIR .. "/latency.txt"
+    local ok, err = renderer.dump_latency(filename)
+    if not ok then
+      core.error("Could not dump input latency: %s", err)
+      return
+    end
+    local t = renderer.get_latency("key")
+    core.log("Key latency p50 %.1fms, p90 %.1fms, p99 %.1fms over %d keys; written to %s",
+      t.p50 * 1000, t.p90 * 1000, t.p99 * 1000, t.count, filename)
+  end,
+
+  ["core:toggle-debug-overlay"] = function()
+    core.debug_overlay = not core.debug_overlay
+    renderer.show_debug(core.debug_overlay, style.font)
+    core.redraw = true
+  end,
+
+  ["core:dump-memory-stats"] = function()
+    local stats = core.get_memory_stats()
+    local filename = EXEDIR .. "/memory.txt"
+    local fp, err = io.open(filename, "wb")
+    if not fp then
+      core.error("Could not write memory stats: %s", err)
+      return
+    end
+    local function kb(bytes) return string.format("%.1f KB", bytes / 1024) end
+    fp:write("lua heap ", kb(stats.lua_heap), " (", stats.lua_allocator, " allocator)\n")
+    if stats.lua_peak then
+      fp:write("lua peak ", kb(stats.lua_peak), "\n")
+      fp:write(string.format("lua allocations %d, frees %d\n", stats.lua_allocations, stats.lua_frees))
+      fp:write(string.format("last frame %d allocations, %s\n", stats.frame_allocations, kb(stats.frame_bytes)))
+    end
+    if stats.pool_arenas then
+      -- blocks are rounded up to their size class, and freed ones wait
+      -- on free lists; both count as fragmentation
+      fp:write(string.format("pool %d arenas (%s), %s in blocks, %s requested, %s free\n",
+        stats.pool_arenas, kb(stats.pool_arena_bytes), kb(stats.pool_block_bytes),
+        kb(stats.pool_requested_bytes), kb(stats.pool_free_bytes)))
+      fp:write(string.format("pool fragmentation %.1f%%, %d pooled and %d large allocations\n",
+        stats.pool_arena_bytes > 0 and (1 - stats.pool_requested_bytes / stats.pool_arena_bytes) * 100 or 0,
+        stats.pool_allocations, stats.pool_large_allocations))
+    end
+    fp:write(gc.get_summary(), string.format(", %d cycles\n", gc.cycles))
+    fp:write("font data ", kb(stats.font_data), ", glyphs ", kb(stats.glyphs), "\n")
+    for _, font in ipairs(stats.fonts) do
+      fp:write(string.format("  %s %gpx: data %s, glyphs %s\n", font.filename, font.size,
+        kb(font.data), kb(font.glyphs)))
+    end
+    fp:write("command buffer ", kb(stats.command_buffer), ", peak ", kb(stats.command_buffer_peak), "\n")
+    fp:write("surface ", kb(stats.surface), "\n")
+    for _, doc in ipairs(stats.docs) do
+      fp:write(string.format("doc %s: lines %s, highlight %s, undo %s\n", doc.name,
+        kb(doc.lines), kb(doc.highlight), kb(doc.undo)))
+    end
+    fp:close()
+    core.log("Lua heap %s; memory stats written to %s", kb(stats.lua_heap), filename)
+  end,
+
+  ["core:start-profiler"] = function()
+    if system.profiler.start() then
+      core.log("Profiler started")
+    end
+  end,
+
+  ["core:stop-profiler"] = function()
+    if not system.profiler.is_running() then return end
+    system.profiler.stop()
+    local filename = EXEDIR .. "/profile.folded"
+    local count, err = system.profiler.write(filename)
+    if not count then
+      core.error("Could not write profile: %s", err)
+      return
+    end
+    core.log("Profiler stopped; %d samples written to %s", count, filename)
+  end,
+
   ["core:new-doc"] = function()
     core.root_view:open_doc(core.open_doc())
   end,
@@ -1,5 +1,6 @@
 local core = require "core"
 local common = require "core.common"
+local config = require "core.config"
 local style = require "core.style"
 local Doc = require "core.doc"
 local DocView = require "core.docview"
@@ -15,8 +16,6 @@ end
 
 local CommandView = DocView:extend()
 
-local max_suggestions = 10
-
 local noop = function() end
 
 local default_state = {
@@ -146,7 +145,7 @@ function CommandView:update_suggestions()
   local t = self.state.suggest(self:get_text()) or {}
   local res = {}
   for i, item in ipairs(t) do
-    if i == max_suggestions then
+    if i == config.max_suggestions then
       break
     end
     if type(item) == "string" then
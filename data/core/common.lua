@@ -54,29 +54,9 @@ function common.color(str)
 end
 
 
-local function compare_score(a, b)
-  return a.score > b.score
-end
-
-local function fuzzy_match_items(items, needle)
-  local res = {}
-  for _, item in ipairs(items) do
-    local score = system.fuzzy_match(tostring(item), needle)
-    if score then
-      table.insert(res, { text = item, score = score })
-    end
-  end
-  table.sort(res, compare_score)
-  for i, item in ipairs(res) do
-    res[i] = item.text
-  end
-  return res
-end
-
-
-function common.fuzzy_match(haystack, needle)
+function common.fuzzy_match(haystack, needle, limit)
   if type(haystack) == "table" then
-    return fuzzy_match_items(haystack, needle)
+    return system.fuzzy_match_list(haystack, needle, limit)
   end
   return system.fuzzy_match(haystack, needle)
 end
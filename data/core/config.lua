@@ -4,11 +4,17 @@ config.project_scan_rate = 5
 config.fps = 60
 config.max_log_items = 80
 config.message_timeout = 3
+config.max_suggestions = 10
 config.mouse_wheel_scroll = 50
 config.file_size_limit = 10
+config.use_ignore_files = true
+config.use_project_index = true
+config.use_project_symbols = true
+config.max_symbol_files_per_poll = 200
 config.symbol_pattern = "[%a_][%w_]*"
 config.non_word_chars = " \t\n/\\()\"':,.;<>~!@#$%^&*|+=[]{}`?-"
 config.treeview_size = 200 * SCALE
+config.treeview_lazy = true
 config.undo_merge_timeout = 0.3
 config.max_undos = 10000
 config.highlight_current_line = true
@@ -16,5 +22,9 @@ config.line_height = 1.2
 config.indent_size = 2
 config.tab_type = "soft"
 config.line_limit = 80
+config.gc_step_size = 16
+config.gc_idle_growth = 1.1
+config.gc_max_growth = 2
+config.gc_input_quiet = 0.1
 
 return config
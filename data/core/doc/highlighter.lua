@@ -1,5 +1,4 @@
 local core = require "core"
-local config = require "core.config"
 local tokenizer = require "core.tokenizer"
 local Object = require "core.object"
 
@@ -15,8 +14,10 @@ function Highlighter:new(doc)
   core.add_thread(function()
     while true do
       if self.first_invalid_line > self.max_wanted_line then
+        -- nothing wanted is stale: sleep until a line is asked for
         self.max_wanted_line = 0
-        coroutine.yield(1 / config.fps)
+        self.suspended = true
+        coroutine.yield(math.huge)
 
       else
         local max = math.min(self.first_invalid_line + 40, self.max_wanted_line)
@@ -34,7 +35,7 @@ function Highlighter:new(doc)
         coroutine.yield()
       end
     end
-  end, self)
+  end, self, core.priority.high)
 end
 
 
@@ -48,6 +49,15 @@ end
 function Highlighter:invalidate(idx)
   self.first_invalid_line = idx
   self.max_wanted_line = math.min(self.max_wanted_line, #self.doc.lines)
+  self:wake()
+end
+
+
+function Highlighter:wake()
+  if self.suspended and self.first_invalid_line <= self.max_wanted_line then
+    self.suspended = false
+    core.wake_thread(self)
+  end
 end
 
 
@@ -68,6 +78,7 @@ function Highlighter:get_line(idx)
     self.lines[idx] = line
   end
   self.max_wanted_line = math.max(self.max_wanted_line, idx)
+  self:wake()
   return line
 end
 
@@ -45,6 +45,7 @@ end
 
 
 function Doc:reset()
+  local removed = self.lines and #self.lines or 0
   self.lines = { "\n" }
   self.selection = { a = { line=1, col=1 }, b = { line=1, col=1 } }
   self.undo_stack = { idx = 1 }
@@ -52,6 +53,7 @@ function Doc:reset()
   self.clean_change_id = 1
   self.highlighter = Highlighter(self)
   self:reset_syntax()
+  self:on_lines_changed(1, removed, 1)
 end
 
 
@@ -81,6 +83,7 @@ function Doc:load(filename)
   end
   fp:close()
   self:reset_syntax()
+  self:on_lines_changed(1, 1, #self.lines)
 end
 
 
@@ -242,6 +245,7 @@ local function insert(self, undo_stack, time, line, col, text)
 
   -- splice lines into line array
   splice(self.lines, line, 1, lines)
+  self:on_lines_changed(line, 1, #lines)
 
   -- push undo
   local line2, col2 = self:position_offset(line, col, #text)
@@ -269,12 +273,19 @@ local function remove(self, undo_stack, time, line1, col1, line2, col2)
 
   -- splice line into line array
   splice(self.lines, line1, line2 - line1 + 1, { before .. after })
+  self:on_lines_changed(line1, line2 - line1 + 1, 1)
 
   -- update highlighter
   self.highlighter:invalidate(line1)
 end
 
 
+-- called after `removed` lines starting at `line` were replaced by the
+-- `added` lines now starting there; plugins hook this to follow edits
+function Doc:on_lines_changed(line, removed, added)
+end
+
+
 function Doc:insert(...)
   insert(self, self.undo_stack, system.get_time(), ...)
   self:sanitize_selection()
@@ -391,4 +402,47 @@ function Doc:select_to(...)
 end
 
 
+-- rough sizes of LuaJIT objects, for Doc:get_memory_estimate()
+local STRING_SIZE, TABLE_SIZE, SLOT_SIZE, NODE_SIZE = 24, 56, 8, 24
+
+local function string_bytes(s)
+  return type(s) == "string" and STRING_SIZE + #s + 1 or 0
+end
+
+local function stack_bytes(stack)
+  local bytes = TABLE_SIZE
+  for _, cmd in pairs(stack) do
+    if type(cmd) == "table" then
+      bytes = bytes + TABLE_SIZE + #cmd * SLOT_SIZE + 2 * NODE_SIZE
+      for _, arg in ipairs(cmd) do bytes = bytes + string_bytes(arg) end
+    end
+  end
+  return bytes
+end
+
+
+-- estimates the bytes held by the lines, by the highlighter's tokens and by
+-- the undo and redo stacks
+function Doc:get_memory_estimate()
+  local lines = TABLE_SIZE + #self.lines * SLOT_SIZE
+  for _, line in ipairs(self.lines) do
+    lines = lines + string_bytes(line)
+  end
+
+  -- token types are interned strings shared by every line, and a line's
+  -- text is usually the doc's own string, so only token texts are counted
+  local highlight = TABLE_SIZE
+  for _, line in pairs(self.highlighter.lines) do
+    local tokens = line.tokens
+    highlight = highlight + TABLE_SIZE + 4 * NODE_SIZE + TABLE_SIZE + #tokens * SLOT_SIZE
+    for i = 2, #tokens, 2 do
+      highlight = highlight + string_bytes(tokens[i])
+    end
+  end
+
+  local undo = stack_bytes(self.undo_stack) + stack_bytes(self.redo_stack)
+  return lines, highlight, undo
+end
+
+
 return Doc
@@ -57,6 +57,7 @@ function DocView:new(doc)
   self.font = "code_font"
   self.last_x_offset = {}
   self.blink_timer = 0
+  self.last_blink_update = system.get_time()
 end
 
 
@@ -250,15 +251,22 @@ function DocView:update()
     self.last_line, self.last_col = line, col
   end
 
-  -- update blink timer
+  -- update blink timer by the time passed, as frames only run when
+  -- something changes, and ask to run again when the caret next toggles
+  local now = system.get_time()
   if self == core.active_view and not self.mouse_selecting then
     local n = blink_period / 2
     local prev = self.blink_timer
-    self.blink_timer = (self.blink_timer + 1 / config.fps) % blink_period
+    self.blink_timer = (self.blink_timer + now - self.last_blink_update) % blink_period
     if (self.blink_timer > n) ~= (prev > n) then
       core.redraw = true
     end
+    if system.window_has_focus() then
+      local toggle = self.blink_timer < n and n or blink_period
+      core.request_wakeup(toggle - self.blink_timer)
+    end
   end
+  self.last_blink_update = now
 
   DocView.super.update(self)
 end
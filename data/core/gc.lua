@@ -0,0 +1,82 @@
+local config = require "core.config"
+
+-- Lua's collector normally runs whenever allocation triggers it, often in
+-- the middle of a keystroke's frame. Here it is stopped, and the main loop
+-- steps it with what is left of a frame's budget once input has been quiet
+-- for a moment. If the heap outgrows config.gc_max_growth times its size
+-- after the last cycle anyway, because input never pauses, the collector
+-- runs on its own again until the next idle step.
+-- Only idle steps are timed: once the collector runs on its own its work
+-- is spread over allocations and can't be told apart from the frame's, so
+-- those times are merely counted in `overdue`.
+local gc = {
+  max_pause = 0,  -- longest time stepped in one go, in seconds
+  time = 0,       -- total time stepped
+  busy = 0,       -- total time of frames, stepping included
+  cycles = 0,
+  overdue = 0,    -- times the collector was let run on its own
+}
+
+local base = 0
+local in_cycle = false
+local running = false
+
+
+function gc.init()
+  collectgarbage("collect")
+  base = collectgarbage("count")
+  collectgarbage("stop")
+end
+
+
+-- whether there is garbage worth collecting in idle time
+function gc.pending()
+  return in_cycle or collectgarbage("count") > base * config.gc_idle_growth
+end
+
+
+-- lets the collector run on its own if the heap grew too much to wait for
+-- idle time
+function gc.check_overdue()
+  if not running and collectgarbage("count") > base * config.gc_max_growth then
+    collectgarbage("restart")
+    running = true
+    gc.overdue = gc.overdue + 1
+  end
+end
+
+
+-- steps the collector for up to `budget` seconds; returns true if a cycle
+-- is still unfinished
+function gc.step(budget)
+  local start = system.get_time()
+  local now = start
+  repeat
+    local done = collectgarbage("step", config.gc_step_size)
+    now = system.get_time()
+    if done then
+      in_cycle = false
+      base = collectgarbage("count")
+      gc.cycles = gc.cycles + 1
+      break
+    end
+    in_cycle = true
+  until now - start >= budget
+  -- stepping sets the collector going on its own again
+  collectgarbage("stop")
+  running = false
+
+  gc.time = gc.time + (now - start)
+  gc.max_pause = math.max(gc.max_pause, now - start)
+  return in_cycle
+end
+
+
+function gc.get_summary()
+  local share = gc.busy > 0 and gc.time / gc.busy * 100 or 0
+  return string.format("idle gc max %.2f ms  %.1f%% of frames  %d overdue",
+    gc.max_pause * 1000, share, gc.overdue)
+end
+
+
+return gc
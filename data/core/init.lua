@@ -1,6 +1,8 @@
 require "core.strict"
 local config = require "core.config"
 local style = require "core.style"
+local gc = require "core.gc"
+local startuptrace = require "core.startuptrace"
 local command
 local keymap
 local RootView
@@ -11,58 +13,72 @@ local Doc
 local core = {}
 
 
-local function project_scan_thread()
-  local function diff_files(a, b)
-    if #a ~= #b then return true end
-    for i, v in ipairs(a) do
-      if b[i].filename ~= v.filename
-      or b[i].modified ~= v.modified then
-        return true
-      end
+local cache_dir
+
+-- EXEDIR/cache, or a per-user cache directory if that is not writable
+local function get_cache_dir()
+  if cache_dir ~= nil then return cache_dir end
+  local dirs = { EXEDIR .. "/cache" }
+  local home = os.getenv("HOME")
+  local user_dir = os.getenv("LOCALAPPDATA") or os.getenv("XDG_CACHE_HOME")
+    or (home and home .. "/.cache")
+  if user_dir then table.insert(dirs, user_dir .. "/lite/cache") end
+
+  cache_dir = false
+  for _, dir in ipairs(dirs) do
+    local probe = dir .. "/.probe"
+    local fp = system.mkdir(dir) and io.open(probe, "wb")
+    if fp then
+      fp:close()
+      os.remove(probe)
+      cache_dir = dir
+      break
     end
   end
+  return cache_dir
+end
 
-  local function compare_file(a, b)
-    return a.filename < b.filename
-  end
 
-  local function get_files(path, t)
-    coroutine.yield()
-    t = t or {}
+local function get_cache_filename(ext)
+  if not config.use_project_index or not get_cache_dir() then return nil end
+  local path = system.absolute_path(core.project_dir) or core.project_dir
+  return get_cache_dir() .. "/" .. path:gsub("[^%w]", "_"):sub(-100) .. ext
+end
+
+
+local function project_scan_thread()
+
+  local function get_files(path)
+    -- the scan runs on a native thread; files matched by .gitignore and
+    -- .ignore files are left out. When the tree view lists directories
+    -- itself the scan only feeds search, so it runs at low priority
     local size_limit = config.file_size_limit * 10e5
-    local all = system.list_dir(path) or {}
-    local dirs, files = {}, {}
-
-    for _, file in ipairs(all) do
-      if not file:find("^%.") then
-        local file = path .. PATHSEP .. file
-        local info = system.get_file_info(file)
-        if info and info.size < size_limit then
-          info.filename = file
-          table.insert(info.type == "dir" and dirs or files, info)
+    local scan = system.project_scan.new(path, size_limit,
+      config.use_ignore_files, get_cache_filename(".idx"), config.treeview_lazy)
+    local shown_cache = #core.project_files > 0
+    while not scan:is_done() do
+      -- show the index saved by the last session until the rescan is done
+      if not shown_cache and scan:has_cached_files() then
+        shown_cache = true
+        local t = scan:get_cached_files()
+        if t then
+          core.project_files = t
+          core.redraw = true
         end
       end
+      -- the scanner posts a wakeup once either tree is ready
+      core.wait_until(function()
+        return scan:is_done() or (not shown_cache and scan:has_cached_files())
+      end)
     end
-
-    table.sort(dirs, compare_file)
-    for _, f in ipairs(dirs) do
-      table.insert(t, f)
-      get_files(f.filename, t)
-    end
-
-    table.sort(files, compare_file)
-    for _, f in ipairs(files) do
-      table.insert(t, f)
-    end
-
-    return t
+    return scan:get_files()
   end
 
   while true do
-    -- get project files and replace previous table if the new table is
+    -- get project files and replace previous tree if the new tree is
     -- different
     local t = get_files(core.project_dir)
-    if diff_files(core.project_files, t) then
+    if not t:equals(core.project_files) then
       core.project_files = t
       core.redraw = true
     end
@@ -73,6 +89,54 @@ local function project_scan_thread()
 end
 
 
+local function new_symbol_harvester()
+  -- languages come from the syntax definitions: plain extension patterns
+  -- such as "%.c$" select the files, and the words of a syntax's symbol
+  -- table are never harvested
+  local syntax = require "core.syntax"
+  local languages = {}
+  for _, t in ipairs(syntax.items) do
+    local language = { extensions = {}, keywords = {}, comment = t.comment }
+    local files = type(t.files) == "table" and t.files or { t.files }
+    for _, pattern in ipairs(files) do
+      local ext = pattern:match("^%%%.([%w_]+)%$$")
+      if ext then table.insert(language.extensions, ext) end
+    end
+    for sym in pairs(t.symbols or {}) do
+      table.insert(language.keywords, sym)
+    end
+    table.insert(languages, language)
+  end
+
+  local size_limit = config.file_size_limit * 10e5
+  return system.symbol_harvester.new(core.project_dir, languages,
+    get_cache_filename(".sym"), size_limit)
+end
+
+
+local function project_symbols_thread()
+  local files
+  while true do
+    local tree = core.project_files
+    if config.use_project_symbols and #core.project_files > 0 then
+      core.project_symbols = core.project_symbols or new_symbol_harvester()
+      -- only changed files are reread when the project tree is replaced
+      if files ~= core.project_files then
+        files = core.project_files
+        core.project_symbols:update(files)
+      end
+      core.project_symbols:poll(config.max_symbol_files_per_poll)
+    end
+    -- the harvester posts a wakeup when files are done, and the scan
+    -- thread replaces the tree
+    core.wait_until(function()
+      return core.project_files ~= tree
+        or (core.project_symbols and core.project_symbols:has_results())
+    end)
+  end
+end
+
+
 function core.init()
   command = require "core.command"
   keymap = require "core.keymap"
@@ -86,7 +150,14 @@ function core.init()
   core.log_items = {}
   core.docs = {}
   core.threads = setmetatable({}, { __mode = "k" })
-  core.project_files = {}
+  core.scheduler = system.scheduler.new()
+  core.fps = config.fps
+  core.next_wakeup = math.huge
+  core.last_event_time = 0
+  core.debug_overlay = false
+  core.workers = {}
+  core.processes = {}
+  core.project_files = system.project_tree.new()
   core.project_dir = "."
 
   local info = ARGS[2] and system.get_file_info(ARGS[2])
@@ -103,10 +174,11 @@ function core.init()
   core.active_view = core.root_view.root_node.a.active_view
 
   core.add_thread(project_scan_thread)
+  core.add_thread(project_symbols_thread, nil, core.priority.idle)
   command.add_defaults()
-  local got_plugin_error = not core.load_plugins()
+  local got_plugin_error = not startuptrace.span("plugins", core.load_plugins)
   local got_user_error = not core.try(require, "user")
-  local got_project_error = not core.load_project_module()
+  local got_project_error = not startuptrace.span("project module", core.load_project_module)
 
   for i = 2, #ARGS do
     local filename = ARGS[i]
@@ -189,10 +261,100 @@ function core.reload_module(name)
 end
 
 
-function core.add_thread(f, weak_ref)
-  local key = weak_ref or #core.threads + 1
+-- thread priorities; lower values run first when a frame is busy
+core.priority = { high = 0, normal = 1, low = 2, idle = 3 }
+
+-- threads by scheduler id; entries go away with their weak_ref's thread
+local threads_by_id = setmetatable({}, { __mode = "v" })
+local next_thread_id = 1
+local running_thread
+local file_waiters = {}
+local wait_checks = {}
+
+function core.add_thread(f, weak_ref, priority)
+  local id = next_thread_id
+  next_thread_id = next_thread_id + 1
+  local key = weak_ref or id
   local fn = function() return core.try(f) end
-  core.threads[key] = { cr = coroutine.create(fn), wake = 0 }
+  local thread = { cr = coroutine.create(fn), id = id, key = key }
+  core.threads[key] = thread
+  threads_by_id[id] = thread
+  core.scheduler:add(id, priority or core.priority.normal)
+end
+
+
+-- queues a thread which suspended itself with `coroutine.yield(math.huge)`
+function core.wake_thread(weak_ref)
+  local thread = core.threads[weak_ref]
+  if thread then
+    core.scheduler:wake(thread.id)
+  end
+end
+
+
+-- waits in the running core thread until a system.async_file request is
+-- done, and returns its result
+function core.await_file(request)
+  if not request:is_done() then
+    local thread = assert(running_thread, "core.await_file needs a core thread")
+    file_waiters[request:get_id()] = thread.id
+    repeat coroutine.yield(math.huge) until request:is_done()
+  end
+  return request:get_result()
+end
+
+
+-- suspends the running core thread until `check()` returns true; checks
+-- run each time the main loop wakes, which native objects with new
+-- results cause by posting a wakeup
+function core.wait_until(check)
+  local thread = assert(running_thread, "core.wait_until needs a core thread")
+  while not check() do
+    wait_checks[thread.id] = check
+    coroutine.yield(math.huge)
+  end
+end
+
+
+local function run_wait_checks()
+  for id, check in pairs(wait_checks) do
+    if check() then
+      wait_checks[id] = nil
+      core.scheduler:wake(id)
+    end
+  end
+end
+
+
+-- asks the main loop to run again within `seconds` even if nothing else
+-- happens, for views whose display changes with time
+function core.request_wakeup(seconds)
+  core.next_wakeup = math.min(core.next_wakeup, system.get_time() + seconds)
+end
+
+
+-- runs the function returned by `module` on its own OS thread and Lua
+-- state; `on_message` receives the values the worker sends, and `on_done`
+-- receives `ok` and the function's results (or the error) once it returns
+function core.spawn_worker(module, on_message, on_done, ...)
+  local worker = system.spawn_worker(module, ...)
+  core.workers[worker:get_id()] = {
+    worker = worker, on_message = on_message, on_done = on_done
+  }
+  return worker
+end
+
+
+-- starts `args[1]` without a shell; `on_output(stream, data)` gets chunks
+-- of "stdout" and "stderr" as they arrive, `on_exit(status)` the exit code
+-- or negated signal number
+function core.start_process(args, on_output, on_exit)
+  local process, err = system.start_process(args)
+  if not process then return nil, err end
+  core.processes[process:get_id()] = {
+    process = process, on_output = on_output, on_exit = on_exit
+  }
+  return process
 end
 
 
@@ -229,10 +391,31 @@ function core.open_doc(filename)
   local doc = Doc(filename)
   table.insert(core.docs, doc)
   core.log_quiet(filename and "Opened doc \"%s\"" or "Opened new doc", filename)
+  core.on_docs_changed()
   return doc
 end
 
 
+-- called after docs are added to or removed from core.docs, so plugins
+-- which follow the open docs need not poll them
+function core.on_docs_changed()
+end
+
+
+-- system.memory_stats() plus an estimate of the memory of each open doc
+function core.get_memory_stats()
+  local stats = system.memory_stats()
+  stats.docs = {}
+  for _, doc in ipairs(core.docs) do
+    local lines, highlight, undo = doc:get_memory_estimate()
+    table.insert(stats.docs, {
+      name = doc:get_name(), lines = lines, highlight = highlight, undo = undo
+    })
+  end
+  return stats
+end
+
+
 function core.get_views_referencing_doc(doc)
   local res = {}
   local views = core.root_view.root_node:get_children()
@@ -291,7 +474,43 @@ end
 
 function core.on_event(type, ...)
   local did_keymap = false
-  if type == "textinput" then
+  if type == "workermessage" then
+    local id, values = ...
+    local w = core.workers[id]
+    if w and w.on_message then
+      w.on_message(table.unpack(values, 1, values.n))
+    end
+  elseif type == "workerdone" then
+    local id, ok, values = ...
+    local w = core.workers[id]
+    core.workers[id] = nil
+    if not ok then
+      core.error("Worker error: %s", tostring(values[1]))
+    end
+    if w and w.on_done then
+      w.on_done(ok, table.unpack(values, 1, values.n))
+    end
+  elseif type == "processoutput" then
+    local id, stream, data = ...
+    local p = core.processes[id]
+    if p and p.on_output then
+      p.on_output(stream, data)
+    end
+  elseif type == "processexit" then
+    local id, status = ...
+    local p = core.processes[id]
+    core.processes[id] = nil
+    if p and p.on_exit then
+      p.on_exit(status)
+    end
+  elseif type == "filedone" then
+    local id = ...
+    local thread_id = file_waiters[id]
+    file_waiters[id] = nil
+    if thread_id then
+      core.scheduler:wake(thread_id)
+    end
+  elseif type == "textinput" then
     core.root_view:on_text_input(...)
   elseif type == "keypressed" then
     did_keymap = keymap.on_key_pressed(...)
@@ -319,27 +538,24 @@ function core.on_event(type, ...)
 end
 
 
+local events = {}
+
 function core.step()
-  -- handle events
+  -- handle events; bursts of mouse motion and wheel turns arrive merged
   local did_keymap = false
-  local mouse_moved = false
-  local mouse = { x = 0, y = 0, dx = 0, dy = 0 }
-
-  for type, a,b,c,d in system.poll_event do
-    if type == "mousemoved" then
-      mouse_moved = true
-      mouse.x, mouse.y = a, b
-      mouse.dx, mouse.dy = mouse.dx + c, mouse.dy + d
-    elseif type == "textinput" and did_keymap then
+  local count = system.poll_events(events)
+  for i = 1, count do
+    local e = events[i]
+    if e.type == "textinput" and did_keymap then
       did_keymap = false
     else
-      local _, res = core.try(core.on_event, type, a, b, c, d)
+      local _, res = core.try(core.on_event, e.type, e.a, e.b, e.c, e.d)
       did_keymap = res or did_keymap
     end
-    core.redraw = true
   end
-  if mouse_moved then
-    core.try(core.on_event, "mousemoved", mouse.x, mouse.y, mouse.dx, mouse.dy)
+  if count > 0 then
+    core.redraw = true
+    core.last_event_time = system.get_time()
   end
 
   local width, height = renderer.get_size()
@@ -347,20 +563,20 @@ function core.step()
   -- update
   core.root_view.size.x, core.root_view.size.y = width, height
   core.root_view:update()
-  if not core.redraw then
-    if not system.window_has_focus() then system.wait_event(0.5) end
-    return
-  end
+  if not core.redraw then return false end
   core.redraw = false
 
   -- close unreferenced docs
+  local closed = false
   for i = #core.docs, 1, -1 do
     local doc = core.docs[i]
     if #core.get_views_referencing_doc(doc) == 0 then
       table.remove(core.docs, i)
       core.log_quiet("Closed doc \"%s\"", doc:get_name())
+      closed = true
     end
   end
+  if closed then core.on_docs_changed() end
 
   -- update window title
   local name = core.active_view:get_name()
@@ -375,49 +591,87 @@ function core.step()
   core.clip_rect_stack[1] = { 0, 0, width, height }
   renderer.set_clip_rect(table.unpack(core.clip_rect_stack[1]))
   core.root_view:draw()
-  renderer.end_frame()
+  if core.debug_overlay then
+    renderer.set_debug_text(gc.get_summary())
+  end
+  -- frames only run on input, so keep drawing while repainted rects fade
+  if renderer.end_frame() then core.redraw = true end
+  return true
 end
 
 
-local run_threads = coroutine.wrap(function()
-  while true do
-    local max_time = 1 / config.fps - 0.004
-    local ran_any_threads = false
-
-    for k, thread in pairs(core.threads) do
-      -- run thread
-      if thread.wake < system.get_time() then
-        local _, wait = assert(coroutine.resume(thread.cr))
-        if coroutine.status(thread.cr) == "dead" then
-          if type(k) == "number" then
-            table.remove(core.threads, k)
-          else
-            core.threads[k] = nil
-          end
-        elseif wait then
-          thread.wake = system.get_time() + wait
-        end
-        ran_any_threads = true
-      end
-
-      -- stop running threads if we're about to hit the end of frame
-      if system.get_time() - core.frame_start > max_time then
-        coroutine.yield()
+local function run_threads()
+  -- sleeping threads wait in the scheduler's timer wheel and cost nothing
+  -- until they are due; ready threads run by priority until the frame
+  -- budget is spent, and whatever is left runs next frame. The budget
+  -- follows config.fps rather than the display, whose frames can be too
+  -- short to leave any time at all
+  local max_time = 1 / config.fps - 0.004
+  local scheduler = core.scheduler
+  scheduler:begin_frame(max_time - (system.get_time() - core.frame_start))
+
+  for id in scheduler.next, scheduler do
+    local thread = threads_by_id[id]
+    if not thread then
+      scheduler:remove(id)
+    else
+      running_thread = thread
+      local _, wait = assert(coroutine.resume(thread.cr))
+      running_thread = nil
+      if coroutine.status(thread.cr) == "dead" then
+        core.threads[thread.key] = nil
+        scheduler:remove(id)
+      elseif wait then
+        scheduler:sleep(id, wait)
+      else
+        scheduler:wake(id)
       end
     end
-
-    if not ran_any_threads then coroutine.yield() end
   end
-end)
+end
 
 
 function core.run()
+  gc.init()
   while true do
     core.frame_start = system.get_time()
-    core.step()
+    core.fps = system.get_refresh_rate() or config.fps
+    core.next_wakeup = math.huge
+    local did_redraw = core.step()
+    run_wait_checks()
     run_threads()
-    local elapsed = system.get_time() - core.frame_start
-    system.sleep(math.max(0, 1 / config.fps - elapsed))
+    gc.check_overdue()
+
+    -- garbage is collected with the rest of the frame's budget, once input
+    -- has been quiet for config.gc_input_quiet
+    local frame_time = 1 / core.fps
+    local quiet_in = core.last_event_time + config.gc_input_quiet - system.get_time()
+    local collecting = false
+    if gc.pending() and quiet_in <= 0 then
+      local budget = 1 / config.fps - 0.002 - (system.get_time() - core.frame_start)
+      if budget > 0 then collecting = gc.step(budget) end
+    end
+    gc.busy = gc.busy + (system.get_time() - core.frame_start)
+
+    if did_redraw or core.redraw or core.scheduler:has_ready() then
+      -- frames follow each other at the display's refresh rate while
+      -- something changes
+      local elapsed = system.get_time() - core.frame_start
+      system.sleep(math.max(0, frame_time - elapsed))
+    else
+      -- nothing to draw or run: block until an event arrives, a thread is
+      -- due, a view's deadline passes or garbage can be collected
+      local timeout = core.scheduler:get_time_until_wake()
+      if core.next_wakeup < math.huge then
+        local until_wakeup = math.max(0, core.next_wakeup - system.get_time())
+        timeout = math.min(timeout or until_wakeup, until_wakeup)
+      end
+      if collecting or gc.pending() then
+        local until_quiet = collecting and 0 or math.max(0, quiet_in)
+        timeout = math.min(timeout or until_quiet, until_quiet)
+      end
+      system.wait_event(timeout)
+    end
   end
 end
 
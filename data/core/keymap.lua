@@ -86,6 +86,7 @@ end
 keymap.add {
   ["ctrl+shift+p"] = "core:command-finder",
   ["ctrl+p"] = "core:file-finder",
+  ["ctrl+t"] = "core:find-symbol",
   ["ctrl+o"] = "core:open-file",
   ["ctrl+n"] = "core:new-doc",
   ["alt+return"] = "core:toggle-fullscreen",
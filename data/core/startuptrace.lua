@@ -0,0 +1,46 @@
+-- Lua's part of the startup trace LITE_STARTUP_TRACE asks for: spans for
+-- each module required and each font loaded, and for the steps core.init
+-- wraps in `span`. The wrappers remove themselves once the first frame
+-- has ended the trace.
+local startuptrace = {}
+
+local trace = system.startup_trace
+
+
+-- calls `fn` inside a span called `name` while tracing
+function startuptrace.span(name, fn, ...)
+  if not trace.is_enabled() then return fn(...) end
+  trace.begin_span(name)
+  local res = { pcall(fn, ...) }
+  trace.end_span()
+  if not res[1] then error(res[2], 0) end
+  return table.unpack(res, 2, table.maxn(res))
+end
+
+
+function startuptrace.install()
+  if not trace.is_enabled() then return end
+
+  local require_, load_font = require, renderer.font.load
+  local function uninstall()
+    require = require_
+    renderer.font.load = load_font
+  end
+
+  require = function(name)
+    if not trace.is_enabled() then uninstall() end
+    if package.loaded[name] ~= nil or not trace.is_enabled() then
+      return require_(name)
+    end
+    return startuptrace.span("require " .. name, require_, name)
+  end
+
+  renderer.font.load = function(filename, size)
+    if not trace.is_enabled() then uninstall() end
+    return startuptrace.span(string.format("font %s %g", filename, size),
+      load_font, filename, size)
+  end
+end
+
+
+return startuptrace
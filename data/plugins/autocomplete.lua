@@ -7,6 +7,7 @@ local keymap = require "core.keymap"
 local translate = require "core.doc.translate"
 local RootView = require "core.rootview"
 local DocView = require "core.docview"
+local Doc = require "core.doc"
 
 config.autocomplete_max_suggestions = 6
 
@@ -26,62 +27,77 @@ function autocomplete.add(t)
 end
 
 
-core.add_thread(function()
-  local cache = setmetatable({}, { __mode = "k" })
-
-  local function get_symbols(doc)
-    local i = 1
-    local s = {}
-    while i < #doc.lines do
-      for sym in doc.lines[i]:gmatch(config.symbol_pattern) do
-        s[sym] = true
-      end
-      i = i + 1
-      if i % 100 == 0 then coroutine.yield() end
+-- symbols of open docs live in a native index which follows every edit,
+-- so nothing is rescanned when a doc changes
+local index = system.symbol_index.new()
+local doc_ids = {}
+local next_doc_id = 1
+
+
+-- the native scanner only knows the default pattern; any other pattern
+-- is matched here and the symbols handed over per line
+local default_symbol_pattern = "[%a_][%w_]*"
+
+local function splice_symbols(id, line, removed, lines, added)
+  if config.symbol_pattern == default_symbol_pattern then
+    index:splice(id, line, removed, lines, added)
+    return
+  end
+  local symbols = {}
+  for i = 1, added do
+    local t = {}
+    for sym in lines[line + i - 1]:gmatch(config.symbol_pattern) do
+      table.insert(t, sym)
     end
-    return s
+    symbols[i] = t
   end
+  index:splice_symbols(id, line, removed, symbols)
+end
+
 
-  local function cache_is_valid(doc)
-    local c = cache[doc]
-    return c and c.last_change_id == doc:get_change_id()
+local on_lines_changed = Doc.on_lines_changed
+
+function Doc:on_lines_changed(line, removed, added)
+  on_lines_changed(self, line, removed, added)
+  local id = doc_ids[self]
+  if id then
+    splice_symbols(id, line, removed, self.lines, added)
   end
+end
+
+
+local docs_changed = true
+local on_docs_changed = core.on_docs_changed
+
+function core.on_docs_changed()
+  on_docs_changed()
+  docs_changed = true
+end
+
 
+core.add_thread(function()
   while true do
-    local symbols = {}
+    core.wait_until(function() return docs_changed end)
+    docs_changed = false
 
-    -- lift all symbols from all docs
+    -- index docs opened since the last pass and drop closed ones
+    local open = {}
     for _, doc in ipairs(core.docs) do
-      -- update the cache if the doc has changed since the last iteration
-      if not cache_is_valid(doc) then
-        cache[doc] = {
-          last_change_id = doc:get_change_id(),
-          symbols = get_symbols(doc)
-        }
-      end
-      -- update symbol set with doc's symbol set
-      for sym in pairs(cache[doc].symbols) do
-        symbols[sym] = true
+      open[doc] = true
+      if not doc_ids[doc] then
+        doc_ids[doc] = next_doc_id
+        splice_symbols(next_doc_id, 1, 0, doc.lines, #doc.lines)
+        next_doc_id = next_doc_id + 1
       end
-      coroutine.yield()
     end
-
-    -- update symbols list
-    autocomplete.add { name = "open-docs", items = symbols }
-
-    -- wait for next scan
-    local valid = true
-    while valid do
-      coroutine.yield(1)
-      for _, doc in ipairs(core.docs) do
-        if not cache_is_valid(doc) then
-          valid = false
-        end
+    for doc, id in pairs(doc_ids) do
+      if not open[doc] then
+        index:remove_doc(id)
+        doc_ids[doc] = nil
       end
     end
-
   end
-end)
+end, nil, core.priority.low)
 
 
 local partial = ""
@@ -99,26 +115,42 @@ end
 local function update_suggestions()
   local doc = core.active_view.doc
   local filename = doc and doc.filename or ""
+  local max = config.autocomplete_max_suggestions
+
+  -- symbols from open docs starting with the partial symbol, then those
+  -- harvested from the rest of the project
+  local items, by_text = {}, {}
+  local function add_symbols(symbols)
+    for _, text in ipairs(symbols) do
+      if not by_text[text] then
+        local item = setmetatable({ text = text }, mt)
+        table.insert(items, item)
+        by_text[text] = item
+      end
+    end
+  end
+  add_symbols(index:complete(partial, max))
+  if core.project_symbols and #items < max then
+    add_symbols(core.project_symbols:complete(partial, max - #items))
+  end
 
-  -- get all relevant suggestions for given filename
-  local items = {}
+  -- fuzzy match the lists added by other plugins, merging duplicates
   for _, v in pairs(autocomplete.map) do
     if common.match_pattern(filename, v.files) then
-      for _, item in pairs(v.items) do
-        table.insert(items, item)
+      for _, item in ipairs(common.fuzzy_match(v.items, partial, max)) do
+        local existing = by_text[item.text]
+        if existing then
+          existing.info = existing.info or item.info
+        else
+          table.insert(items, item)
+          by_text[item.text] = item
+        end
       end
     end
   end
 
-  -- fuzzy match, remove duplicates and store
-  items = common.fuzzy_match(items, partial)
-  local j = 1
-  for i = 1, config.autocomplete_max_suggestions do
-    suggestions[i] = items[j]
-    while items[j] and items[i].text == items[j].text do
-      items[i].info = items[i].info or items[j].info
-      j = j + 1
-    end
+  for i = 1, max do
+    suggestions[i] = items[i]
   end
 end
 
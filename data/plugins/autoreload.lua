@@ -11,10 +11,22 @@ local function update_time(doc)
 end
 
 
+local function is_open(doc)
+  for _, d in ipairs(core.docs) do
+    if d == doc then return true end
+  end
+  return false
+end
+
+
 local function reload_doc(doc)
-  local fp = io.open(doc.filename, "r")
-  local text = fp:read("*a")
-  fp:close()
+  -- the doc may be edited or closed while the file is read; the text is
+  -- dropped then and the next scan tries again
+  local change_id = doc:get_change_id()
+  local text = core.await_file(system.async_file.read(doc.filename))
+  if not text or doc:get_change_id() ~= change_id or not is_open(doc) then
+    return
+  end
 
   local sel = { doc:get_selection() }
   doc:remove(1, 1, math.huge, math.huge)
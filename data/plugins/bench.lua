@@ -0,0 +1,194 @@
+local core = require "core"
+local common = require "core.common"
+local command = require "core.command"
+
+-- Records editing sessions and replays them as a benchmark. A session
+-- holds the docs which were open and every event, grouped by frame. With
+-- LITE_REPLAY set to a session file the editor replays it at full speed
+-- instead of running normally, writes percentiles of the frame timings
+-- to LITE_REPLAY_REPORT (or the session file plus ".report") and quits.
+
+local recorded_events = {
+  ["keypressed"]     = true,
+  ["keyreleased"]    = true,
+  ["textinput"]      = true,
+  ["mousemoved"]     = true,
+  ["mousepressed"]   = true,
+  ["mousereleased"]  = true,
+  ["mousewheel"]     = true,
+  ["resized"]        = true,
+}
+
+local recording
+local frame_count = 0
+
+
+local on_event = core.on_event
+
+core.on_event = function(type, ...)
+  if recording and recorded_events[type] then
+    local frames = recording.frames
+    local frame = frames[#frames]
+    if not frame or frame.index ~= frame_count then
+      frame = { index = frame_count }
+      table.insert(frames, frame)
+    end
+    table.insert(frame, { type, ... })
+  end
+  return on_event(type, ...)
+end
+
+
+local step = core.step
+
+core.step = function(...)
+  frame_count = frame_count + 1
+  return step(...)
+end
+
+
+local function serialize(value)
+  if type(value) == "table" then
+    local items = {}
+    for k, v in pairs(value) do
+      table.insert(items, "[" .. serialize(k) .. "]=" .. serialize(v))
+    end
+    return "{" .. table.concat(items, ",") .. "}"
+  elseif type(value) == "string" then
+    return string.format("%q", value)
+  end
+  return tostring(value)
+end
+
+
+local function write_session(filename)
+  -- frames are stored by their offset from the first recorded one
+  local first = recording.frames[1] and recording.frames[1].index or 0
+  for _, frame in ipairs(recording.frames) do
+    frame.index = frame.index - first
+  end
+  local fp = assert( io.open(filename, "wb") )
+  fp:write("return ", serialize(recording), "\n")
+  fp:close()
+  core.log("Saved session of %d frames to %s", #recording.frames, filename)
+end
+
+
+command.add(nil, {
+  ["bench:toggle-record"] = function()
+    if not recording then
+      local files = {}
+      for _, doc in ipairs(core.docs) do
+        if doc.filename then table.insert(files, doc.filename) end
+      end
+      local av = core.active_view
+      recording = {
+        files = files,
+        active = av.doc and av.doc.filename,
+        size = { core.root_view.size.x, core.root_view.size.y },
+        frames = {},
+      }
+      core.log("Recording session...")
+      return
+    end
+
+    local session = recording
+    recording = nil
+    core.command_view:enter("Save Session As", function(filename)
+      recording = session
+      core.try(write_session, filename)
+      recording = nil
+    end, common.path_suggest)
+  end,
+})
+
+
+local function percentiles(values)
+  table.sort(values)
+  local function at(p)
+    if #values == 0 then return 0 end
+    return values[math.max(1, math.ceil(p * #values))]
+  end
+  return at(0.5), at(0.9), at(0.99), at(1)
+end
+
+
+local function replay(filename, report_filename)
+  local session = assert(loadfile(filename))()
+
+  -- layout and dirty areas depend on the window size, so timings are only
+  -- comparable at the recorded one
+  local w, h = table.unpack(session.size)
+  local got_w, got_h = system.set_window_size(w, h)
+  if got_w ~= w or got_h ~= h then
+    error(string.format("session was recorded at %dx%d, window is %dx%d",
+      w, h, got_w, got_h))
+  end
+
+  -- start from the recorded docs, freshly loaded
+  for _, file in ipairs(session.files) do
+    core.root_view:open_doc(core.open_doc(file))
+  end
+  if session.active then
+    core.root_view:open_doc(core.open_doc(session.active))
+  end
+
+  -- time the phases of each frame
+  local timings = { update = {}, draw = {}, end_frame = {}, dirty_pixels = {} }
+  local root_view = core.root_view
+  local update, draw, end_frame = root_view.update, root_view.draw, renderer.end_frame
+  local function timed(fn, list)
+    return function(...)
+      local start = system.get_time()
+      fn(...)
+      table.insert(list, (system.get_time() - start) * 1000)
+    end
+  end
+  root_view.update = timed(update, timings.update)
+  root_view.draw = timed(draw, timings.draw)
+  renderer.end_frame = timed(end_frame, timings.end_frame)
+
+  -- feed each recorded frame's events, then draw it; frames without events
+  -- in between are drawn once, so animations still run
+  local frame_index = 0
+  for _, frame in ipairs(session.frames) do
+    while frame_index < frame.index do
+      core.redraw = true
+      core.step()
+      frame_index = frame_index + 1
+    end
+    for _, ev in ipairs(frame) do
+      core.try(on_event, table.unpack(ev))
+    end
+    core.redraw = true
+    core.step()
+    local _, dirty = renderer.get_frame_stats()
+    table.insert(timings.dirty_pixels, dirty)
+    frame_index = frame_index + 1
+  end
+
+  root_view.update, root_view.draw, renderer.end_frame = update, draw, end_frame
+
+  local fp = assert( io.open(report_filename, "wb") )
+  fp:write(string.format("# %s: %d frames\n", filename, #session.frames))
+  fp:write("# metric p50 p90 p99 max\n")
+  for _, name in ipairs { "update", "draw", "end_frame", "dirty_pixels" } do
+    local unit = name == "dirty_pixels" and "px" or "ms"
+    local line = string.format("%s_%s %.3f %.3f %.3f %.3f\n", name, unit,
+      percentiles(timings[name]))
+    fp:write(line)
+    io.write(line)
+  end
+  fp:close()
+end
+
+
+local replay_filename = os.getenv("LITE_REPLAY")
+
+if replay_filename then
+  core.run = function()
+    local report = os.getenv("LITE_REPLAY_REPORT") or replay_filename .. ".report"
+    local ok = core.try(replay, replay_filename, report)
+    os.exit(ok and 0 or 1)
+  end
+end
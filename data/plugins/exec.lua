@@ -2,25 +2,98 @@ local core = require "core"
 local command = require "core.command"
 
 
-local function exec(cmd)
+-- runs `cmd` through io.popen where processes can't be started in the
+-- background; blocks until it exits. `input` goes through a temporary file
+-- as popen pipes only go one way
+local function exec_blocking(cmd, input, on_done)
+  local tmp
+  if input then
+    tmp = os.tmpname()
+    local fp = io.open(tmp, "wb")
+    if not fp then
+      core.error("Could not write input for \"%s\" to %s", cmd, tmp)
+      return
+    end
+    fp:write(input)
+    fp:close()
+    cmd = string.format("%s < \"%s\"", cmd, tmp)
+  end
   local fp = io.popen(cmd, "r")
-  local res = fp:read("*a")
-  fp:close()
-  return res:gsub("%\n$", "")
+  local res = fp and fp:read("*a")
+  if fp then fp:close() end
+  if tmp then os.remove(tmp) end
+  if not res then
+    core.error("Could not run \"%s\"", cmd)
+    return
+  end
+  on_done((res:gsub("%\n$", "")))
+end
+
+
+-- runs `cmd` through the shell in the background, feeding it `input`, and
+-- calls `on_done` with its output once it exits
+local function exec(cmd, input, on_done)
+  local output, errors = {}, {}
+  local process, err = core.start_process({ "sh", "-c", cmd },
+    function(stream, data)
+      table.insert(stream == "stdout" and output or errors, data)
+    end,
+    function(status)
+      if status ~= 0 then
+        core.error("\"%s\" exited with %d: %s", cmd, status, table.concat(errors))
+        return
+      end
+      local res = table.concat(output):gsub("%\n$", "")
+      on_done(res)
+    end)
+  if not process then
+    if err:find("not supported", 1, true) then
+      exec_blocking(cmd, input, on_done)
+      return
+    end
+    core.error("Could not run \"%s\": %s", cmd, err)
+    return
+  end
+  if input then process:write(input) end
+  process:close_stdin()
 end
 
 
 command.add("core.docview", {
   ["exec:insert"] = function()
     core.command_view:enter("Insert Result Of Command", function(cmd)
-      core.active_view.doc:text_input(exec(cmd))
+      local doc = core.active_view.doc
+      exec(cmd, nil, function(res)
+        doc:text_input(res)
+      end)
     end)
   end,
 
   ["exec:replace"] = function()
     core.command_view:enter("Replace With Result Of Command", function(cmd)
-      core.active_view.doc:replace(function(str)
-        return exec(string.format("echo %q | %s", str, cmd))
+      local doc = core.active_view.doc
+      local had_selection = doc:has_selection()
+      local line1, col1, line2, col2, swap
+      if had_selection then
+        line1, col1, line2, col2, swap = doc:get_selection(true)
+      else
+        line1, col1, line2, col2 = 1, 1, #doc.lines, #doc.lines[#doc.lines]
+      end
+      local old_text = doc:get_text(line1, col1, line2, col2)
+
+      exec(cmd, old_text, function(res)
+        -- the result only applies to the text it was made from
+        if doc:get_text(line1, col1, line2, col2) ~= old_text then
+          core.error("Text changed while \"%s\" ran; result dropped", cmd)
+          return
+        end
+        if had_selection then
+          doc:set_selection(line1, col1, line2, col2, swap)
+        else
+          local line, col = doc:get_selection()
+          doc:set_selection(line, col)
+        end
+        doc:replace(function() return res end)
       end)
     end)
   end,
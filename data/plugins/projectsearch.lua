@@ -8,6 +8,8 @@ local View = require "core.view"
 
 local ResultsView = View:extend()
 
+local read_ahead_count = 8
+
 
 function ResultsView:new(text, fn)
   ResultsView.super.new(self)
@@ -22,11 +24,11 @@ function ResultsView:get_name()
 end
 
 
-local function find_all_matches_in_file(t, filename, fn)
-  local fp = io.open(filename)
-  if not fp then return t end
+local function find_all_matches_in_file(t, filename, text, fn)
+  if not text or text == "" then return t end
+  if text:byte(-1) ~= 10 then text = text .. "\n" end
   local n = 1
-  for line in fp:lines() do
+  for line in text:gmatch("(.-)\n") do
     local s = fn(line)
     if s then
       table.insert(t, { file = filename, text = line, line = n, col = s })
@@ -36,7 +38,6 @@ local function find_all_matches_in_file(t, filename, fn)
     n = n + 1
     core.redraw = true
   end
-  fp:close()
 end
 
 
@@ -49,9 +50,25 @@ function ResultsView:begin_search(text, fn)
   self.selected_idx = 0
 
   core.add_thread(function()
-    for i, file in ipairs(core.project_files) do
-      if file.type == "file" then
-        find_all_matches_in_file(self.results, file.filename, fn)
+    -- files are read on the I/O threads a few ahead of the one searched
+    local files = core.project_files
+    local requests = {}
+    local function read_ahead(i)
+      for j = i, math.min(i + read_ahead_count, #files) do
+        local filename, type = files:get_info(j)
+        if type == "file" and not requests[j] then
+          requests[j] = system.async_file.read(filename)
+        end
+      end
+    end
+
+    for i = 1, #files do
+      read_ahead(i)
+      local filename, type = files:get_info(i)
+      if type == "file" then
+        local text = core.await_file(requests[i])
+        requests[i] = nil
+        find_all_matches_in_file(self.results, filename, text, fn)
       end
       self.last_file_idx = i
     end
@@ -10,37 +10,23 @@ local View = require "core.view"
 local TreeView = View:extend()
 
 
-local function get_depth(filename)
-  local n = 0
-  for sep in filename:gmatch("[\\/]") do
-    n = n + 1
-  end
-  return n
-end
-
-
 function TreeView:new()
   TreeView.super.new(self)
   self.scrollable = true
   self.focusable = false
   self.visible = true
   self.init_size = true
-  self.cache = {}
-end
-
-
-function TreeView:get_cached(item)
-  local t = self.cache[item.filename]
-  if not t then
-    t = {}
-    t.filename = item.filename
-    t.abs_filename = system.absolute_path(item.filename)
-    t.path, t.name = t.filename:match("^(.*)[\\/](.+)$")
-    t.depth = get_depth(t.filename)
-    t.type = item.type
-    self.cache[t.filename] = t
+  -- rows on screen are looked up in the native model; nothing walks the
+  -- whole tree per frame
+  self.model = system.tree_model.new()
+  if config.treeview_lazy then
+    -- list directories on demand instead of waiting for the project scan
+    local size_limit = config.file_size_limit * 10e5
+    self.lister = system.dir_lister.new(core.project_dir, size_limit,
+      config.use_ignore_files)
+    self.last_refresh = system.get_time()
+    self.lister:request("")
   end
-  return t
 end
 
 
@@ -54,71 +40,88 @@ function TreeView:get_item_height()
 end
 
 
-function TreeView:check_cache()
-  -- invalidate cache's skip values if project_files has changed
-  if core.project_files ~= self.last_project_files then
-    for _, v in pairs(self.cache) do
-      v.skip = nil
-    end
-    self.last_project_files = core.project_files
+function TreeView:get_scrollable_size()
+  return #self.model * self:get_item_height() + style.padding.y * 2
+end
+
+
+function TreeView:get_active_path()
+  -- resolve the active doc to its path relative to the project; cached
+  -- until the doc changes
+  local doc = core.active_view.doc
+  local filename = doc and doc.filename
+  local c = self.active_cache
+  if c and c.filename == filename then
+    return c.path
+  end
+
+  local path
+  local abs_filename = filename and system.absolute_path(filename)
+  local abs_dir = system.absolute_path(core.project_dir)
+  if abs_filename and abs_dir
+  and abs_filename:sub(1, #abs_dir + 1) == abs_dir .. PATHSEP then
+    path = abs_filename:sub(#abs_dir + 2)
   end
+  self.active_cache = { filename = filename, path = path }
+  return path
 end
 
 
 function TreeView:each_item()
-  return coroutine.wrap(function()
-    self:check_cache()
-    local ox, oy = self:get_content_offset()
-    local y = oy + style.padding.y
-    local w = self.size.x
-    local h = self:get_item_height()
-
-    local i = 1
-    while i <= #core.project_files do
-      local item = core.project_files[i]
-      local cached = self:get_cached(item)
-
-      coroutine.yield(cached, ox, y, w, h)
-      y = y + h
-      i = i + 1
-
-      if not cached.expanded then
-        if cached.skip then
-          i = cached.skip
-        else
-          local depth = cached.depth
-          while i <= #core.project_files do
-            local filename = core.project_files[i].filename
-            if get_depth(filename) <= depth then break end
-            i = i + 1
-          end
-          cached.skip = i
-        end
-      end
+  -- visits only the rows inside the view
+  local ox, oy = self:get_content_offset()
+  local h = self:get_item_height()
+  local w = self.size.x
+  local top = oy + style.padding.y
+  local first = math.max(1, math.floor((self.position.y - top) / h) + 1)
+  local last = math.min(#self.model,
+    math.floor((self.position.y + self.size.y - top) / h) + 1)
+  local row = first - 1
+  return function()
+    row = row + 1
+    if row <= last then
+      return row, ox, top + (row - 1) * h, w, h
     end
-  end)
+  end
 end
 
 
 function TreeView:on_mouse_moved(px, py)
-  self.hovered_item = nil
-  for item, x,y,w,h in self:each_item() do
-    if px > x and py > y and px <= x + w and py <= y + h then
-      self.hovered_item = item
-      break
-    end
+  self.mouse_x, self.mouse_y = px, py
+  local ox, oy = self:get_content_offset()
+  local h = self:get_item_height()
+  local row = math.floor((py - oy - style.padding.y) / h) + 1
+  if px > ox and px <= ox + self.size.x and row >= 1 and row <= #self.model then
+    self.hovered_row = row
+  else
+    self.hovered_row = nil
+  end
+end
+
+
+function TreeView:update_hovered_row()
+  -- rows shift when listings arrive, so find the row under the mouse again
+  if self.mouse_x then
+    self:on_mouse_moved(self.mouse_x, self.mouse_y)
   end
 end
 
 
 function TreeView:on_mouse_pressed(button, x, y)
-  if not self.hovered_item then
+  local row = self.hovered_row
+  if not row or row > #self.model then
     return
-  elseif self.hovered_item.type == "dir" then
-    self.hovered_item.expanded = not self.hovered_item.expanded
+  end
+  local _, type, _, expanded = self.model:get_item(row)
+  if type == "dir" then
+    self.model:set_expanded(row, not expanded)
+    if self.lister and not expanded then
+      self.lister:request(self.model:get_path(row) .. "/")
+    end
   else
+    local filename = self.model:get_filename(row)
     core.try(function()
-      core.root_view:open_doc(core.open_doc(self.hovered_item.filename))
+      core.root_view:open_doc(core.open_doc(filename))
     end)
   end
 end
@@ -134,6 +137,27 @@ function TreeView:update()
     self:move_towards(self.size, "x", dest)
   end
 
+  if self.lister then
+    -- collect finished directory listings, and relist the open
+    -- directories every so often
+    if self.model:poll(self.lister) then
+      self:update_hovered_row()
+      core.redraw = true
+    end
+    if system.get_time() - self.last_refresh > config.project_scan_rate then
+      self.last_refresh = system.get_time()
+      self.lister:request("")
+      for _, path in ipairs(self.model:get_expanded()) do
+        self.lister:request(path .. "/")
+      end
+    end
+    core.request_wakeup(self.last_refresh + config.project_scan_rate - system.get_time())
+  elseif self.tree ~= core.project_files then
+    self.tree = core.project_files
+    self.model:set_tree(self.tree)
+    self:update_hovered_row()
+  end
+
   TreeView.super.update(self)
 end
 
@@ -141,33 +165,32 @@ end
 function TreeView:draw()
   self:draw_background(style.background2)
 
-  local h = self:get_item_height()
   local icon_width = style.icon_font:get_width("D")
   local spacing = style.font:get_width(" ") * 2
-  local root_depth = get_depth(core.project_dir) + 1
 
-  local doc = core.active_view.doc
-  local active_filename = doc and system.absolute_path(doc.filename or "")
+  local active_path = self:get_active_path()
+  local active_row = active_path and self.model:find_row(active_path)
 
-  for item, x,y,w,h in self:each_item() do
+  for row, x,y,w,h in self:each_item() do
+    local name, type, depth, expanded = self.model:get_item(row)
     local color = style.text
 
     -- highlight active_view doc
-    if item.abs_filename == active_filename then
+    if row == active_row then
       color = style.accent
     end
 
     -- hovered item background
-    if item == self.hovered_item then
+    if row == self.hovered_row then
       renderer.draw_rect(x, y, w, h, style.line_highlight)
       color = style.accent
     end
 
     -- icons
-    x = x + (item.depth - root_depth) * style.padding.x + style.padding.x
-    if item.type == "dir" then
-      local icon1 = item.expanded and "-" or "+"
-      local icon2 = item.expanded and "D" or "d"
+    x = x + depth * style.padding.x + style.padding.x
+    if type == "dir" then
+      local icon1 = expanded and "-" or "+"
+      local icon2 = expanded and "D" or "d"
       common.draw_text(style.icon_font, color, icon1, nil, x, y, 0, h)
       x = x + style.padding.x
       common.draw_text(style.icon_font, color, icon2, nil, x, y, 0, h)
@@ -180,7 +203,7 @@ function TreeView:draw()
 
     -- text
     x = x + spacing
-    x = common.draw_text(style.font, color, item.name, nil, x, y, 0, h)
+    x = common.draw_text(style.font, color, name, nil, x, y, 0, h)
   end
 end
 
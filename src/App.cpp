@@ -6,14 +6,21 @@
  */
 
 #include "App.h"
+#include "memory/LuaAllocator.h"
+#include "profiler/Profiler.h"
+#include "profiler/StartupTrace.h"
 #include <filesystem>
+#include <string.h>
 
 #ifdef _WIN32
 #include <Windows.h>
 #endif
 
 
-App::App() : renderCache(nullptr), renderer(nullptr), window(nullptr), L(luaL_newstate())
+// LITE_ALLOCATOR=pool gives the Lua state a size-class pool instead of
+// malloc, and LITE_HUGEPAGES backs the pool's arenas with huge pages
+App::App() : renderCache(nullptr), renderer(nullptr), window(nullptr),
+	L(LuaAllocator::newState(LuaAllocator::parseMode(getenv("LITE_ALLOCATOR")), getenv("LITE_HUGEPAGES") != nullptr))
 {
 }
 
@@ -28,6 +35,9 @@ App::~App()
 	if (window != nullptr)
 		SDL_DestroyWindow(window);
 
+	// the sampler's hook is set on the state being closed
+	Profiler::stop();
+
 	if (L != nullptr)
 		lua_close(L);
 
@@ -89,11 +99,19 @@ void App::createWindow()
 	renderCache = new RenderCache(*renderer);
 }
 
-void App::setupLuaState() 
+void App::setupLuaState(int argc, char** argv) 
 {
 	luaL_openlibs(L);
 	ApiBridge::InitializeLibs(renderCache, renderer, window, L);
 
+	lua_newtable(L);
+	for (int i = 0; i < argc; i++)
+	{
+		lua_pushstring(L, argv[i]);
+		lua_rawseti(L, -2, i + 1);
+	}
+	lua_setglobal(L, "ARGS");
+
 	lua_pushstring(L, "1.0");
 	lua_setglobal(L, "VERSION");
 
@@ -116,7 +134,13 @@ void App::start(int argc, char** argv)
 	SetProcessDPIAware();
 #endif
 
-	SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS);
+	// LITE_STARTUP_TRACE=filename times startup up to the first frame
+	StartupTrace::init(getenv("LITE_STARTUP_TRACE"));
+
+	{
+		StartupSpan span("SDL_Init");
+		SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS);
+	}
 	SDL_EnableScreenSaver();
 	SDL_EventState(SDL_DROPFILE, SDL_ENABLE);
 	std::atexit(SDL_Quit);
@@ -125,9 +149,25 @@ void App::start(int argc, char** argv)
 	SDL_SetHint(SDL_HINT_MOUSE_FOCUS_CLICKTHROUGH, "1");
 #endif
 
-	createWindow();
-	setupLuaState();
-
+	// the bundle is built without a window and the editor does not start
+	if (argc > 1 && strcmp(argv[1], "--build-bundle") == 0)
+	{
+		setupLuaState(argc, argv);
+		luaL_dostring(L, BuildBundleScript);
+		return;
+	}
+
+	{
+		StartupSpan span("createWindow");
+		createWindow();
+	}
+	{
+		StartupSpan span("setupLuaState");
+		setupLuaState(argc, argv);
+	}
+
+	// ends with the trace, at the first frame
+	if (StartupTrace::isEnabled()) StartupTrace::begin("InitScript");
 	luaL_dostring(L, InitScript);
 	std::getchar();
 }
@@ -22,7 +22,7 @@ private:
 	double getDPIScale();
 
 	void createWindow();
-	void setupLuaState();
+	void setupLuaState(int argc, char** argv);
 
 public:
 	App();
@@ -39,8 +39,11 @@ xpcall(function()
   PATHSEP = package.config:sub(1, 1)
   package.path = EXEDIR .. '/data/?.lua;' .. package.path
   package.path = EXEDIR .. '/data/?/init.lua;' .. package.path
+  local startuptrace = require('core.startuptrace')
+  startuptrace.install()
+  startuptrace.span('bundle', require('core.bundle').install, EXEDIR .. '/data.bundle')
   core = require('core')
-  core.init()
+  startuptrace.span('core.init', core.init)
   core.run()
 end, function(err)
   print('Error: ' .. tostring(err))
@@ -50,4 +53,19 @@ end, function(err)
   end
   --os.exit(1)
 end)
+)MULTI";
+
+
+// run instead of InitScript by `--build-bundle [filename]`
+inline const char* BuildBundleScript = R"MULTI(
+xpcall(function()
+  PATHSEP = package.config:sub(1, 1)
+  package.path = EXEDIR .. '/data/?.lua;' .. package.path
+  local filename = ARGS[3] or EXEDIR .. '/data.bundle'
+  local count = require('core.bundle').build(EXEDIR .. '/data', filename)
+  print(string.format('Wrote %d modules to %s', count, filename))
+end, function(err)
+  print('Error: ' .. tostring(err))
+  print(debug.traceback(nil, 2))
+end)
 )MULTI";
\ No newline at end of file
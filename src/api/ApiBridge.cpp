@@ -29,3 +29,32 @@ void ApiBridge::InitializeLibs(RenderCache* renderCacheInst, Renderer* rendererI
 		lua_setfield(L, -3, lib->name);
     }
 }
+
+void ApiBridge::CheckStringList(lua_State* L, int idx, std::vector<std::string_view>& items)
+{
+	luaL_checktype(L, idx, LUA_TTABLE);
+	auto count = lua_objlen(L, idx);
+	items.resize(count);
+
+	lua_newtable(L);
+	int scratch = lua_gettop(L);
+	for (size_t i = 0; i < count; i++) {
+		lua_rawgeti(L, idx, i + 1);
+		bool converted = lua_type(L, -1) != LUA_TSTRING;
+		if (converted) {
+			lua_getglobal(L, "tostring");
+			lua_insert(L, -2);
+			lua_call(L, 1, 1);
+		}
+
+		size_t len;
+		const char* text = lua_tolstring(L, -1, &len);
+		items[i] = text ? std::string_view(text, len) : std::string_view();
+
+		if (converted) {
+			lua_rawseti(L, scratch, i + 1);
+		} else {
+			lua_pop(L, 1);
+		}
+	}
+}
@@ -2,6 +2,8 @@
 
 #include <lua.hpp>
 #include <functional>
+#include <string_view>
+#include <vector>
 
 #include "../rendering/RenderCache.h"
 #include "../rendering/Renderer.h"
@@ -9,4 +11,9 @@
 namespace ApiBridge
 {
 	void InitializeLibs(RenderCache* renderCache, Renderer* render, SDL_Window* window, lua_State* L);
+
+	// reads the array at `idx` as strings, converting non-strings with
+	// `tostring()`; pushes a table anchoring the converted strings, which
+	// must stay on the stack while `items` is in use
+	void CheckStringList(lua_State* L, int idx, std::vector<std::string_view>& items);
 }
\ No newline at end of file
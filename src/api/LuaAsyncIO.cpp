@@ -0,0 +1,127 @@
+#include "ApiBridge.h"
+#include "../io/AsyncIO.h"
+
+typedef std::shared_ptr<FileRequest> FileRequestRef;
+
+static FileRequest* check_request(lua_State* L, int idx)
+{
+	auto self = reinterpret_cast<FileRequestRef**>(luaL_checkudata(L, idx, "FileRequest"));
+	if (!*self) luaL_error(L, "file request was destroyed");
+	return (*self)->get();
+}
+
+static int push_request(lua_State* L, FileRequestRef&& request)
+{
+	auto self = reinterpret_cast<FileRequestRef**>(lua_newuserdata(L, sizeof(FileRequestRef*)));
+	*self = new FileRequestRef(std::move(request));
+	luaL_getmetatable(L, "FileRequest");
+	lua_setmetatable(L, -2);
+	return 1;
+}
+
+// system.async_file.read(filename): reads the whole file on an I/O thread
+static int f_read(lua_State* L)
+{
+	const char* path = luaL_checkstring(L, 1);
+	return push_request(L, AsyncIO::get().read(path));
+}
+
+// system.async_file.write(filename, data): replaces the file's contents on
+// an I/O thread
+static int f_write(lua_State* L)
+{
+	const char* path = luaL_checkstring(L, 1);
+	size_t len;
+	const char* data = luaL_checklstring(L, 2, &len);
+	return push_request(L, AsyncIO::get().write(path, std::string(data, len)));
+}
+
+// a read nobody can collect any more is not worth finishing; writes are
+// always carried out
+static int f_gc(lua_State* L)
+{
+	auto self = reinterpret_cast<FileRequestRef**>(luaL_checkudata(L, 1, "FileRequest"));
+	if (*self)
+	{
+		if ((**self)->type == FileRequest::READ) (**self)->cancelled = true;
+		delete *self;
+		*self = nullptr;
+	}
+	return 0;
+}
+
+static int f_is_done(lua_State* L)
+{
+	lua_pushboolean(L, check_request(L, 1)->done);
+	return 1;
+}
+
+// returns the data read, or true once written; nil and a message on failure
+// or nil while not done
+static int f_get_result(lua_State* L)
+{
+	auto request = check_request(L, 1);
+	if (!request->done) return 0;
+	if (!request->error.empty())
+	{
+		lua_pushnil(L);
+		lua_pushstring(L, request->error.c_str());
+		return 2;
+	}
+	if (request->type == FileRequest::READ)
+		lua_pushlstring(L, request->data.data(), request->data.size());
+	else
+		lua_pushboolean(L, 1);
+	return 1;
+}
+
+static int f_cancel(lua_State* L)
+{
+	check_request(L, 1)->cancelled = true;
+	return 0;
+}
+
+static int f_get_id(lua_State* L)
+{
+	lua_pushnumber(L, check_request(L, 1)->id);
+	return 1;
+}
+
+// turns a finished request from system.poll_event into "filedone", id
+int PushFileEvent(lua_State* L, const SDL_Event& e)
+{
+	lua_pushstring(L, "filedone");
+	lua_pushnumber(L, static_cast<uint32_t>(e.user.code));
+	return 2;
+}
+
+
+int InitializeAsyncIO(lua_State* L)
+{
+	const luaL_Reg meta[] =
+	{
+		{ "__gc",			f_gc			},
+		{ "is_done",		f_is_done		},
+		{ "get_result",		f_get_result	},
+		{ "cancel",			f_cancel		},
+		{ "get_id",			f_get_id		},
+		{ NULL,				NULL			}
+	};
+
+	luaL_newmetatable(L, "FileRequest");
+	luaL_setfuncs(L, meta, 0);
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+	lua_pop(L, 1);
+
+	const luaL_Reg lib[] =
+	{
+		{ "read",			f_read			},
+		{ "write",			f_write			},
+		{ NULL,				NULL			}
+	};
+
+	AsyncIO::getEventType();
+	luaL_newlib(L, lib);
+	return 1;
+}
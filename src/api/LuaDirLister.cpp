@@ -0,0 +1,78 @@
+#include "ApiBridge.h"
+#include "../project/DirLister.h"
+
+static int f_new(lua_State* L)
+{
+	auto root = luaL_checkstring(L, 1);
+	auto sizeLimit = luaL_optnumber(L, 2, 0);
+	bool useIgnoreFiles = lua_isnoneornil(L, 3) || lua_toboolean(L, 3);
+
+	auto self = reinterpret_cast<DirLister**>(lua_newuserdata(L, sizeof(DirLister*)));
+	*self = new DirLister(root, static_cast<uint64_t>(sizeLimit), useIgnoreFiles);
+	luaL_getmetatable(L, "DirLister");
+	lua_setmetatable(L, -2);
+	return 1;
+}
+
+static int f_gc(lua_State* L)
+{
+	auto self = reinterpret_cast<DirLister**>(luaL_checkudata(L, 1, "DirLister"));
+	if (*self)
+	{
+		delete *self;
+		*self = nullptr;
+	}
+	return 0;
+}
+
+static int f_request(lua_State* L)
+{
+	auto self = reinterpret_cast<DirLister**>(luaL_checkudata(L, 1, "DirLister"));
+	(*self)->request(luaL_checkstring(L, 2));
+	return 0;
+}
+
+static int f_poll(lua_State* L)
+{
+	auto self = reinterpret_cast<DirLister**>(luaL_checkudata(L, 1, "DirLister"));
+	std::string relPath;
+	DirListing listing;
+	if (!(*self)->poll(relPath, listing)) return 0;
+
+	lua_pushlstring(L, relPath.c_str(), relPath.size());
+	lua_createtable(L, listing.children.size(), 0);
+	int i = 1;
+	for (auto& child : listing.children)
+	{
+		lua_createtable(L, 0, 4);
+		lua_pushlstring(L, child.fileName.c_str(), child.fileName.size());
+		lua_setfield(L, -2, "name");
+		lua_pushstring(L, child.isDir ? "dir" : "file");
+		lua_setfield(L, -2, "type");
+		lua_pushnumber(L, static_cast<lua_Number>(child.size));
+		lua_setfield(L, -2, "size");
+		lua_pushnumber(L, static_cast<lua_Number>(child.modified));
+		lua_setfield(L, -2, "modified");
+		lua_rawseti(L, -2, i++);
+	}
+	return 2;
+}
+
+
+int InitializeDirLister(lua_State* L)
+{
+	const luaL_Reg lib[] =
+	{
+		{ "__gc",			f_gc		},
+		{ "new",			f_new		},
+		{ "request",		f_request	},
+		{ "poll",			f_poll		},
+		{ NULL,				NULL		}
+	};
+
+	luaL_newmetatable(L, "DirLister");
+	luaL_setfuncs(L, lib, 0);
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+	return 1;
+}
@@ -0,0 +1,106 @@
+#include "ApiBridge.h"
+#include "../search/FuzzySession.h"
+
+struct LuaFuzzySession
+{
+	FuzzySession* session;
+	int itemsRef;
+};
+
+// pushes a session created natively; its results are the session's own
+// strings rather than values from a Lua table
+void PushFuzzySession(lua_State* L, FuzzySession* session)
+{
+	auto self = reinterpret_cast<LuaFuzzySession*>(lua_newuserdata(L, sizeof(LuaFuzzySession)));
+	self->session = session;
+	self->itemsRef = LUA_NOREF;
+	luaL_getmetatable(L, "FuzzySession");
+	lua_setmetatable(L, -2);
+}
+
+static int f_new(lua_State* L)
+{
+	std::vector<std::string_view> items;
+	ApiBridge::CheckStringList(L, 1, items);
+
+	auto self = reinterpret_cast<LuaFuzzySession*>(lua_newuserdata(L, sizeof(LuaFuzzySession)));
+	self->session = new FuzzySession(items);
+
+	// keep the original items so results can be returned as-is
+	lua_pushvalue(L, 1);
+	self->itemsRef = luaL_ref(L, LUA_REGISTRYINDEX);
+
+	luaL_getmetatable(L, "FuzzySession");
+	lua_setmetatable(L, -2);
+	return 1;
+}
+
+static int f_gc(lua_State* L)
+{
+	auto self = reinterpret_cast<LuaFuzzySession*>(luaL_checkudata(L, 1, "FuzzySession"));
+	if (self->session)
+	{
+		luaL_unref(L, LUA_REGISTRYINDEX, self->itemsRef);
+		delete self->session;
+		self->session = nullptr;
+	}
+	return 0;
+}
+
+static int f_filter(lua_State* L)
+{
+	auto self = reinterpret_cast<LuaFuzzySession*>(luaL_checkudata(L, 1, "FuzzySession"));
+	size_t len;
+	auto query = luaL_checklstring(L, 2, &len);
+	auto limit = static_cast<size_t>(luaL_optnumber(L, 3, 0));
+
+	size_t total;
+	auto matches = self->session->filter({ query, len }, limit, total);
+
+	lua_rawgeti(L, LUA_REGISTRYINDEX, self->itemsRef);
+	int items = lua_gettop(L);
+
+	lua_createtable(L, matches.size(), 0);
+	int i = 1;
+	for (auto& match : matches)
+	{
+		if (self->itemsRef == LUA_NOREF)
+		{
+			auto item = self->session->getItem(match.index);
+			lua_pushlstring(L, item.data(), item.size());
+		}
+		else
+		{
+			lua_rawgeti(L, items, match.index + 1);
+		}
+		lua_rawseti(L, -2, i++);
+	}
+	lua_pushnumber(L, total);
+	return 2;
+}
+
+static int f_len(lua_State* L)
+{
+	auto self = reinterpret_cast<LuaFuzzySession*>(luaL_checkudata(L, 1, "FuzzySession"));
+	lua_pushnumber(L, self->session->size());
+	return 1;
+}
+
+
+int InitializeFuzzySession(lua_State* L)
+{
+	const luaL_Reg lib[] =
+	{
+		{ "__gc",			f_gc		},
+		{ "__len",			f_len		},
+		{ "new",			f_new		},
+		{ "filter",			f_filter	},
+		{ NULL,				NULL		}
+	};
+
+	luaL_newmetatable(L, "FuzzySession");
+	luaL_setfuncs(L, lib, 0);
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+	return 1;
+}
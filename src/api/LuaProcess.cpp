@@ -0,0 +1,136 @@
+#include "ApiBridge.h"
+#include "../process/Process.h"
+
+static Process* check_process(lua_State* L, int idx)
+{
+	auto self = reinterpret_cast<Process**>(luaL_checkudata(L, idx, "Process"));
+	if (!*self) luaL_error(L, "process was destroyed");
+	return *self;
+}
+
+// system.start_process({ program, args... }): starts `program` without a
+// shell; returns nil and a message if it could not be started
+static int f_start_process(lua_State* L)
+{
+	luaL_checktype(L, 1, LUA_TTABLE);
+	std::vector<std::string> args;
+	auto count = lua_objlen(L, 1);
+	for (size_t i = 1; i <= count; i++)
+	{
+		lua_rawgeti(L, 1, static_cast<int>(i));
+		size_t len;
+		const char* arg = luaL_checklstring(L, -1, &len);
+		args.emplace_back(arg, len);
+		lua_pop(L, 1);
+	}
+
+	auto process = new Process();
+	std::string error;
+	if (!process->start(args, error))
+	{
+		delete process;
+		lua_pushnil(L);
+		lua_pushstring(L, error.c_str());
+		return 2;
+	}
+
+	auto self = reinterpret_cast<Process**>(lua_newuserdata(L, sizeof(Process*)));
+	*self = process;
+	luaL_getmetatable(L, "Process");
+	lua_setmetatable(L, -2);
+	return 1;
+}
+
+// kills the process if it still runs
+static int f_gc(lua_State* L)
+{
+	auto self = reinterpret_cast<Process**>(luaL_checkudata(L, 1, "Process"));
+	if (*self)
+	{
+		delete *self;
+		*self = nullptr;
+	}
+	return 0;
+}
+
+static int f_write(lua_State* L)
+{
+	auto process = check_process(L, 1);
+	size_t len;
+	const char* data = luaL_checklstring(L, 2, &len);
+	process->write(data, len);
+	return 0;
+}
+
+static int f_close_stdin(lua_State* L)
+{
+	check_process(L, 1)->closeStdin();
+	return 0;
+}
+
+static int f_kill(lua_State* L)
+{
+	auto process = check_process(L, 1);
+	lua_pushboolean(L, process->kill(lua_toboolean(L, 2)));
+	return 1;
+}
+
+static int f_is_running(lua_State* L)
+{
+	lua_pushboolean(L, check_process(L, 1)->isRunning());
+	return 1;
+}
+
+static int f_get_id(lua_State* L)
+{
+	lua_pushnumber(L, check_process(L, 1)->getId());
+	return 1;
+}
+
+// turns a process event from system.poll_event into
+// "processoutput", id, "stdout" | "stderr", data or "processexit", id, status;
+// returns 0 if the process is gone
+int PushProcessEvent(lua_State* L, const SDL_Event& e)
+{
+	auto process = Process::find(static_cast<uint32_t>(e.user.code));
+	ProcessEvent event;
+	if (!process || !process->receive(event)) return 0;
+
+	if (event.type == ProcessEvent::EXIT)
+	{
+		lua_pushstring(L, "processexit");
+		lua_pushnumber(L, process->getId());
+		lua_pushnumber(L, event.status);
+		return 3;
+	}
+	lua_pushstring(L, "processoutput");
+	lua_pushnumber(L, process->getId());
+	lua_pushstring(L, event.type == ProcessEvent::STDOUT ? "stdout" : "stderr");
+	lua_pushlstring(L, event.data.data(), event.data.size());
+	return 4;
+}
+
+
+int InitializeProcess(lua_State* L)
+{
+	const luaL_Reg lib[] =
+	{
+		{ "__gc",			f_gc			},
+		{ "write",			f_write			},
+		{ "close_stdin",	f_close_stdin	},
+		{ "kill",			f_kill			},
+		{ "is_running",		f_is_running	},
+		{ "get_id",			f_get_id		},
+		{ NULL,				NULL			}
+	};
+
+	luaL_newmetatable(L, "Process");
+	luaL_setfuncs(L, lib, 0);
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+	lua_pop(L, 1);
+
+	Process::getEventType();
+	lua_pushcfunction(L, f_start_process);
+	return 1;
+}
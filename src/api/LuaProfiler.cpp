@@ -0,0 +1,58 @@
+#include "ApiBridge.h"
+#include "../profiler/Profiler.h"
+
+// system.profiler.start([interval]): samples every `interval` seconds,
+// 1ms by default; must be called from the main state
+static int f_start(lua_State* L)
+{
+	double interval = luaL_optnumber(L, 1, 0.001);
+	if (interval <= 0) return luaL_argerror(L, 1, "interval must be positive");
+	if (!lua_pushthread(L)) return luaL_error(L, "the profiler must be started from the main state");
+	lua_pop(L, 1);
+	lua_pushboolean(L, Profiler::start(L, interval));
+	return 1;
+}
+
+static int f_stop(lua_State* L)
+{
+	Profiler::stop();
+	return 0;
+}
+
+static int f_is_running(lua_State* L)
+{
+	lua_pushboolean(L, Profiler::isRunning());
+	return 1;
+}
+
+// system.profiler.write(filename): writes the folded stacks; returns the
+// number of samples
+static int f_write(lua_State* L)
+{
+	const char* path = luaL_checkstring(L, 1);
+	uint64_t count;
+	if (!Profiler::write(path, count))
+	{
+		lua_pushnil(L);
+		lua_pushfstring(L, "could not write %s", path);
+		return 2;
+	}
+	lua_pushnumber(L, static_cast<lua_Number>(count));
+	return 1;
+}
+
+
+int InitializeProfiler(lua_State* L)
+{
+	const luaL_Reg lib[] =
+	{
+		{ "start",			f_start			},
+		{ "stop",			f_stop			},
+		{ "is_running",		f_is_running	},
+		{ "write",			f_write			},
+		{ NULL,				NULL			}
+	};
+
+	luaL_newlib(L, lib);
+	return 1;
+}
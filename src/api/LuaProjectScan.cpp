@@ -0,0 +1,83 @@
+#include "ApiBridge.h"
+#include "../project/ProjectScanner.h"
+
+static int f_new(lua_State* L)
+{
+	auto path = luaL_checkstring(L, 1);
+	auto sizeLimit = luaL_optnumber(L, 2, 0);
+	bool useIgnoreFiles = lua_isnoneornil(L, 3) || lua_toboolean(L, 3);
+	auto cacheFile = luaL_optstring(L, 4, "");
+	bool lowPriority = lua_toboolean(L, 5);
+
+	auto self = reinterpret_cast<ProjectScanner**>(lua_newuserdata(L, sizeof(ProjectScanner*)));
+	*self = new ProjectScanner(path, static_cast<uint64_t>(sizeLimit), useIgnoreFiles, cacheFile, lowPriority);
+	luaL_getmetatable(L, "ProjectScan");
+	lua_setmetatable(L, -2);
+	return 1;
+}
+
+static int f_gc(lua_State* L)
+{
+	auto self = reinterpret_cast<ProjectScanner**>(luaL_checkudata(L, 1, "ProjectScan"));
+	if (*self)
+	{
+		delete *self;
+		*self = nullptr;
+	}
+	return 0;
+}
+
+static int f_is_done(lua_State* L)
+{
+	auto self = reinterpret_cast<ProjectScanner**>(luaL_checkudata(L, 1, "ProjectScan"));
+	lua_pushboolean(L, (*self)->isDone());
+	return 1;
+}
+
+static int f_has_cached_files(lua_State* L)
+{
+	auto self = reinterpret_cast<ProjectScanner**>(luaL_checkudata(L, 1, "ProjectScan"));
+	lua_pushboolean(L, (*self)->hasCachedTree());
+	return 1;
+}
+
+extern void PushProjectTree(lua_State* L, ProjectTree* tree);
+
+static int f_get_files(lua_State* L)
+{
+	auto self = reinterpret_cast<ProjectScanner**>(luaL_checkudata(L, 1, "ProjectScan"));
+	auto tree = (*self)->takeTree();
+	if (!tree) return 0;
+	PushProjectTree(L, tree.release());
+	return 1;
+}
+
+static int f_get_cached_files(lua_State* L)
+{
+	auto self = reinterpret_cast<ProjectScanner**>(luaL_checkudata(L, 1, "ProjectScan"));
+	auto tree = (*self)->takeCachedTree();
+	if (!tree) return 0;
+	PushProjectTree(L, tree.release());
+	return 1;
+}
+
+
+int InitializeProjectScan(lua_State* L)
+{
+	const luaL_Reg lib[] =
+	{
+		{ "__gc",			f_gc		},
+		{ "new",			f_new		},
+		{ "is_done",		f_is_done	},
+		{ "get_files",		f_get_files	},
+		{ "get_cached_files", f_get_cached_files },
+		{ "has_cached_files", f_has_cached_files },
+		{ NULL,				NULL		}
+	};
+
+	luaL_newmetatable(L, "ProjectScan");
+	luaL_setfuncs(L, lib, 0);
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+	return 1;
+}
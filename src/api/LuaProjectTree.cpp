@@ -0,0 +1,177 @@
+#include "ApiBridge.h"
+#include "../project/ProjectTree.h"
+#include "../search/FuzzySession.h"
+
+#ifdef _WIN32
+#define PATHSEP '\\'
+#else
+#define PATHSEP '/'
+#endif
+
+extern void PushFuzzySession(lua_State* L, FuzzySession* session);
+
+void PushProjectTree(lua_State* L, ProjectTree* tree)
+{
+	auto self = reinterpret_cast<ProjectTree**>(lua_newuserdata(L, sizeof(ProjectTree*)));
+	*self = tree;
+	luaL_getmetatable(L, "ProjectTree");
+	lua_setmetatable(L, -2);
+}
+
+static ProjectTree* check_tree(lua_State* L, int idx)
+{
+	return *reinterpret_cast<ProjectTree**>(luaL_checkudata(L, idx, "ProjectTree"));
+}
+
+// converts a 1-based Lua index into a node index
+static size_t check_index(lua_State* L, ProjectTree* tree, int idx)
+{
+	auto i = static_cast<size_t>(luaL_checknumber(L, idx));
+	luaL_argcheck(L, i >= 1 && i <= tree->size(), idx, "index out of range");
+	return i - 1;
+}
+
+static int f_new(lua_State* L)
+{
+	PushProjectTree(L, new ProjectTree());
+	return 1;
+}
+
+static int f_gc(lua_State* L)
+{
+	auto self = reinterpret_cast<ProjectTree**>(luaL_checkudata(L, 1, "ProjectTree"));
+	if (*self)
+	{
+		delete *self;
+		*self = nullptr;
+	}
+	return 0;
+}
+
+static int f_len(lua_State* L)
+{
+	lua_pushnumber(L, check_tree(L, 1)->size());
+	return 1;
+}
+
+static int f_get_info(lua_State* L)
+{
+	auto tree = check_tree(L, 1);
+	auto idx = check_index(L, tree, 2);
+	auto& node = tree->getNode(idx);
+	auto fileName = tree->getFileName(idx);
+	lua_pushlstring(L, fileName.c_str(), fileName.size());
+	lua_pushstring(L, node.isDir ? "dir" : "file");
+	lua_pushnumber(L, static_cast<lua_Number>(node.size));
+	lua_pushnumber(L, node.modified);
+	return 4;
+}
+
+static int f_get_filename(lua_State* L)
+{
+	auto tree = check_tree(L, 1);
+	auto fileName = tree->getFileName(check_index(L, tree, 2));
+	lua_pushlstring(L, fileName.c_str(), fileName.size());
+	return 1;
+}
+
+static int f_get_name(lua_State* L)
+{
+	auto tree = check_tree(L, 1);
+	auto& name = tree->getName(check_index(L, tree, 2));
+	lua_pushlstring(L, name.c_str(), name.size());
+	return 1;
+}
+
+static int f_get_type(lua_State* L)
+{
+	auto tree = check_tree(L, 1);
+	lua_pushstring(L, tree->getNode(check_index(L, tree, 2)).isDir ? "dir" : "file");
+	return 1;
+}
+
+static int f_get_depth(lua_State* L)
+{
+	auto tree = check_tree(L, 1);
+	lua_pushnumber(L, tree->getNode(check_index(L, tree, 2)).depth);
+	return 1;
+}
+
+static int f_get_parent(lua_State* L)
+{
+	auto tree = check_tree(L, 1);
+	auto parent = tree->getNode(check_index(L, tree, 2)).parent;
+	if (parent == PROJECT_NO_PARENT) return 0;
+	lua_pushnumber(L, parent + 1);
+	return 1;
+}
+
+// index of the first entry after the given entry's subtree
+static int f_get_skip(lua_State* L)
+{
+	auto tree = check_tree(L, 1);
+	lua_pushnumber(L, tree->getNode(check_index(L, tree, 2)).end + 1);
+	return 1;
+}
+
+static int f_find(lua_State* L)
+{
+	auto tree = check_tree(L, 1);
+	size_t len;
+	auto path = luaL_checklstring(L, 2, &len);
+	auto idx = tree->find({ path, len });
+	if (idx < 0) return 0;
+	lua_pushnumber(L, static_cast<lua_Number>(idx + 1));
+	return 1;
+}
+
+static int f_equals(lua_State* L)
+{
+	auto tree = check_tree(L, 1);
+	auto other = check_tree(L, 2);
+	lua_pushboolean(L, tree->equals(*other));
+	return 1;
+}
+
+// creates a fuzzy session over the relative paths of all files
+static int f_new_fuzzy_session(lua_State* L)
+{
+	auto tree = check_tree(L, 1);
+	std::vector<std::string> paths;
+	for (size_t i = 0; i < tree->size(); i++)
+	{
+		if (!tree->getNode(i).isDir) paths.push_back(tree->getRelativePath(i, PATHSEP));
+	}
+
+	std::vector<std::string_view> items(paths.begin(), paths.end());
+	PushFuzzySession(L, new FuzzySession(items));
+	return 1;
+}
+
+
+int InitializeProjectTree(lua_State* L)
+{
+	const luaL_Reg lib[] =
+	{
+		{ "__gc",				f_gc				},
+		{ "__len",				f_len				},
+		{ "new",				f_new				},
+		{ "get_info",			f_get_info			},
+		{ "get_filename",		f_get_filename		},
+		{ "get_name",			f_get_name			},
+		{ "get_type",			f_get_type			},
+		{ "get_depth",			f_get_depth			},
+		{ "get_parent",			f_get_parent		},
+		{ "get_skip",			f_get_skip			},
+		{ "find",				f_find				},
+		{ "equals",				f_equals			},
+		{ "new_fuzzy_session",	f_new_fuzzy_session	},
+		{ NULL,					NULL				}
+	};
+
+	luaL_newmetatable(L, "ProjectTree");
+	luaL_setfuncs(L, lib, 0);
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+	return 1;
+}
@@ -2,6 +2,8 @@
 
 #include "ApiBridge.h"
 #include "../rendering/RenderCache.h"
+#include "../memory/LuaAllocator.h"
+#include "../profiler/StartupTrace.h"
 
 Renderer* renderer;
 RenderCache* renderCache;
@@ -25,13 +27,93 @@ static RenColor check_color(lua_State* L, int idx, int def)
 	return color;
 }
 
+// renderer.show_debug(enable, [font]): outlines repainted rects and shows
+// frame statistics in the top right corner, written with `font`
 static int f_show_debug(lua_State* L)
 {
 	luaL_checkany(L, 1);
-	renderCache->showDebug(lua_toboolean(L, 1));
+	RenFont* font = nullptr;
+	if (!lua_isnoneornil(L, 2))
+		font = *reinterpret_cast<RenFont**>(luaL_checkudata(L, 2, "Font"));
+	renderCache->showDebug(lua_toboolean(L, 1), font);
 	return 0;
 }
 
+// renderer.set_debug_text(text): an extra line for the debug overlay, such
+// as statistics only Lua knows
+static int f_set_debug_text(lua_State* L)
+{
+	renderCache->setDebugText(luaL_optstring(L, 1, ""));
+	return 0;
+}
+
+static LatencyKind check_latency_kind(lua_State* L, int idx)
+{
+	static const char* kinds[] = { "key", "pointer", NULL };
+	return static_cast<LatencyKind>(luaL_checkoption(L, idx, "key", kinds));
+}
+
+// renderer.get_latency([kind]): input-to-photon latency summary in seconds
+// for "key" or "pointer" input
+static int f_get_latency(lua_State* L)
+{
+	auto kind = check_latency_kind(L, 1);
+	auto& latency = renderCache->getLatency();
+	lua_createtable(L, 0, 6);
+	lua_pushnumber(L, static_cast<lua_Number>(latency.getCount(kind)));
+	lua_setfield(L, -2, "count");
+	lua_pushnumber(L, latency.getMean(kind));
+	lua_setfield(L, -2, "mean");
+	lua_pushnumber(L, latency.getPercentile(kind, 0.5));
+	lua_setfield(L, -2, "p50");
+	lua_pushnumber(L, latency.getPercentile(kind, 0.9));
+	lua_setfield(L, -2, "p90");
+	lua_pushnumber(L, latency.getPercentile(kind, 0.99));
+	lua_setfield(L, -2, "p99");
+	lua_pushnumber(L, latency.getMax(kind));
+	lua_setfield(L, -2, "max");
+	return 1;
+}
+
+static int f_get_latency_percentile(lua_State* L)
+{
+	auto kind = check_latency_kind(L, 1);
+	double p = luaL_checknumber(L, 2);
+	lua_pushnumber(L, renderCache->getLatency().getPercentile(kind, p));
+	return 1;
+}
+
+static int f_dump_latency(lua_State* L)
+{
+	const char* path = luaL_checkstring(L, 1);
+	if (!renderCache->getLatency().dump(path))
+	{
+		lua_pushnil(L);
+		lua_pushfstring(L, "could not write %s", path);
+		return 2;
+	}
+	lua_pushboolean(L, 1);
+	return 1;
+}
+
+static int f_reset_latency(lua_State* L)
+{
+	renderCache->getLatency().reset();
+	return 0;
+}
+
+// renderer.get_frame_stats(): the rects and pixels the last end_frame
+// updated on the window
+static int f_get_frame_stats(lua_State* L)
+{
+	int rectCount;
+	int64_t dirtyPixels;
+	renderCache->getFrameStats(rectCount, dirtyPixels);
+	lua_pushnumber(L, rectCount);
+	lua_pushnumber(L, static_cast<lua_Number>(dirtyPixels));
+	return 2;
+}
+
 static int f_get_size(lua_State* L)
 {
 	int w, h;
@@ -47,10 +129,16 @@ static int f_begin_frame(lua_State* L)
 	return 0;
 }
 
+// renderer.end_frame(): presents the frame; returns true if the debug
+// overlay needs more frames to fade out what was repainted
 static int f_end_frame(lua_State* L)
 {
+	renderCache->setLuaHeap(static_cast<size_t>(lua_gc(L, LUA_GCCOUNT, 0)) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0));
 	renderCache->endFrame();
-	return 0;
+	LuaAllocator::endFrame();
+	if (StartupTrace::isEnabled()) StartupTrace::finish("first end_frame");
+	lua_pushboolean(L, renderCache->hasDebugRects());
+	return 1;
 }
 
 static int f_set_clip_rect(lua_State* L)
@@ -96,14 +184,20 @@ int InitializeLuaRenderer(lua_State* L)
 {
 	const luaL_Reg lib[] = 
 	{
-		{ "show_debug",		f_show_debug	},
-		{ "get_size",		f_get_size		},
-		{ "begin_frame",	f_begin_frame	},
-		{ "end_frame",		f_end_frame		},
-		{ "set_clip_rect",	f_set_clip_rect	},
-		{ "draw_rect",		f_draw_rect		},
-		{ "draw_text",		f_draw_text		},
-		{ NULL,				NULL			},
+		{ "show_debug",				f_show_debug				},
+		{ "set_debug_text",			f_set_debug_text			},
+		{ "get_latency",			f_get_latency				},
+		{ "get_latency_percentile",	f_get_latency_percentile	},
+		{ "dump_latency",			f_dump_latency				},
+		{ "reset_latency",			f_reset_latency				},
+		{ "get_frame_stats",		f_get_frame_stats			},
+		{ "get_size",				f_get_size					},
+		{ "begin_frame",			f_begin_frame				},
+		{ "end_frame",				f_end_frame					},
+		{ "set_clip_rect",			f_set_clip_rect				},
+		{ "draw_rect",				f_draw_rect					},
+		{ "draw_text",				f_draw_text					},
+		{ NULL,						NULL						},
 	};
 
 	luaL_newlib(L, lib);
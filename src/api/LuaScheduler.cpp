@@ -0,0 +1,110 @@
+#include "ApiBridge.h"
+#include "../scheduler/Scheduler.h"
+
+static Scheduler* check_scheduler(lua_State* L, int idx)
+{
+	return *reinterpret_cast<Scheduler**>(luaL_checkudata(L, idx, "Scheduler"));
+}
+
+static uint32_t check_id(lua_State* L, int idx)
+{
+	return static_cast<uint32_t>(luaL_checknumber(L, idx));
+}
+
+static int f_new(lua_State* L)
+{
+	auto self = reinterpret_cast<Scheduler**>(lua_newuserdata(L, sizeof(Scheduler*)));
+	*self = new Scheduler();
+	luaL_getmetatable(L, "Scheduler");
+	lua_setmetatable(L, -2);
+	return 1;
+}
+
+static int f_gc(lua_State* L)
+{
+	auto self = reinterpret_cast<Scheduler**>(luaL_checkudata(L, 1, "Scheduler"));
+	if (*self)
+	{
+		delete *self;
+		*self = nullptr;
+	}
+	return 0;
+}
+
+static int f_add(lua_State* L)
+{
+	check_scheduler(L, 1)->add(check_id(L, 2), static_cast<int>(luaL_optnumber(L, 3, 1)));
+	return 0;
+}
+
+static int f_remove(lua_State* L)
+{
+	check_scheduler(L, 1)->remove(check_id(L, 2));
+	return 0;
+}
+
+static int f_wake(lua_State* L)
+{
+	check_scheduler(L, 1)->wake(check_id(L, 2));
+	return 0;
+}
+
+static int f_sleep(lua_State* L)
+{
+	check_scheduler(L, 1)->sleep(check_id(L, 2), luaL_checknumber(L, 3));
+	return 0;
+}
+
+static int f_begin_frame(lua_State* L)
+{
+	check_scheduler(L, 1)->beginFrame(luaL_checknumber(L, 2));
+	return 0;
+}
+
+// usable as a generic for iterator: `for id in s.next, s do`
+static int f_next(lua_State* L)
+{
+	uint32_t id;
+	if (!check_scheduler(L, 1)->next(id)) return 0;
+	lua_pushnumber(L, id);
+	return 1;
+}
+
+static int f_has_ready(lua_State* L)
+{
+	lua_pushboolean(L, check_scheduler(L, 1)->hasReady());
+	return 1;
+}
+
+static int f_get_time_until_wake(lua_State* L)
+{
+	auto time = check_scheduler(L, 1)->getTimeUntilWake();
+	if (time < 0) return 0;
+	lua_pushnumber(L, time);
+	return 1;
+}
+
+
+int InitializeScheduler(lua_State* L)
+{
+	const luaL_Reg lib[] =
+	{
+		{ "__gc",					f_gc					},
+		{ "new",					f_new					},
+		{ "add",					f_add					},
+		{ "remove",					f_remove				},
+		{ "wake",					f_wake					},
+		{ "sleep",					f_sleep					},
+		{ "begin_frame",			f_begin_frame			},
+		{ "next",					f_next					},
+		{ "has_ready",				f_has_ready				},
+		{ "get_time_until_wake",	f_get_time_until_wake	},
+		{ NULL,						NULL					}
+	};
+
+	luaL_newmetatable(L, "Scheduler");
+	luaL_setfuncs(L, lib, 0);
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+	return 1;
+}
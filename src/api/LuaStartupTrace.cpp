@@ -0,0 +1,35 @@
+#include "ApiBridge.h"
+#include "../profiler/StartupTrace.h"
+
+static int f_is_enabled(lua_State* L)
+{
+	lua_pushboolean(L, StartupTrace::isEnabled());
+	return 1;
+}
+
+static int f_begin_span(lua_State* L)
+{
+	StartupTrace::begin(luaL_checkstring(L, 1));
+	return 0;
+}
+
+static int f_end_span(lua_State* L)
+{
+	StartupTrace::end();
+	return 0;
+}
+
+
+int InitializeStartupTrace(lua_State* L)
+{
+	const luaL_Reg lib[] =
+	{
+		{ "is_enabled",		f_is_enabled	},
+		{ "begin_span",		f_begin_span	},
+		{ "end_span",		f_end_span		},
+		{ NULL,				NULL			}
+	};
+
+	luaL_newlib(L, lib);
+	return 1;
+}
@@ -0,0 +1,175 @@
+#include "ApiBridge.h"
+#include "../search/SymbolHarvester.h"
+
+static SymbolHarvester* check_harvester(lua_State* L, int idx)
+{
+	return *reinterpret_cast<SymbolHarvester**>(luaL_checkudata(L, idx, "SymbolHarvester"));
+}
+
+// reads { extensions = { "c", "h" }, keywords = { "if", ... }, comment = "//" }
+static void check_language(lua_State* L, int idx, HarvestLanguage& language)
+{
+	luaL_checktype(L, idx, LUA_TTABLE);
+
+	lua_getfield(L, idx, "extensions");
+	if (lua_istable(L, -1))
+	{
+		for (int i = 1; lua_rawgeti(L, -1, i), !lua_isnil(L, -1); i++)
+		{
+			language.extensions.emplace_back(luaL_checkstring(L, -1));
+			lua_pop(L, 1);
+		}
+		lua_pop(L, 1);
+	}
+	lua_pop(L, 1);
+
+	lua_getfield(L, idx, "keywords");
+	if (lua_istable(L, -1))
+	{
+		for (int i = 1; lua_rawgeti(L, -1, i), !lua_isnil(L, -1); i++)
+		{
+			language.keywords.emplace(luaL_checkstring(L, -1));
+			lua_pop(L, 1);
+		}
+		lua_pop(L, 1);
+	}
+	lua_pop(L, 1);
+
+	lua_getfield(L, idx, "comment");
+	if (lua_isstring(L, -1)) language.comment = lua_tostring(L, -1);
+	lua_pop(L, 1);
+}
+
+static int f_new(lua_State* L)
+{
+	auto root = luaL_checkstring(L, 1);
+	luaL_checktype(L, 2, LUA_TTABLE);
+	auto cacheFile = luaL_optstring(L, 3, "");
+	auto sizeLimit = luaL_optnumber(L, 4, 0);
+
+	std::vector<HarvestLanguage> languages(lua_objlen(L, 2));
+	for (size_t i = 0; i < languages.size(); i++)
+	{
+		lua_rawgeti(L, 2, i + 1);
+		check_language(L, lua_gettop(L), languages[i]);
+		lua_pop(L, 1);
+	}
+
+	auto self = reinterpret_cast<SymbolHarvester**>(lua_newuserdata(L, sizeof(SymbolHarvester*)));
+	*self = new SymbolHarvester(root, languages, cacheFile, static_cast<uint64_t>(sizeLimit));
+	luaL_getmetatable(L, "SymbolHarvester");
+	lua_setmetatable(L, -2);
+	return 1;
+}
+
+static int f_gc(lua_State* L)
+{
+	auto self = reinterpret_cast<SymbolHarvester**>(luaL_checkudata(L, 1, "SymbolHarvester"));
+	if (*self)
+	{
+		delete *self;
+		*self = nullptr;
+	}
+	return 0;
+}
+
+static int f_len(lua_State* L)
+{
+	lua_pushnumber(L, check_harvester(L, 1)->getFileCount());
+	return 1;
+}
+
+static int f_update(lua_State* L)
+{
+	auto harvester = check_harvester(L, 1);
+	auto tree = *reinterpret_cast<ProjectTree**>(luaL_checkudata(L, 2, "ProjectTree"));
+	harvester->update(*tree);
+	return 0;
+}
+
+static int f_poll(lua_State* L)
+{
+	auto harvester = check_harvester(L, 1);
+	auto limit = static_cast<size_t>(luaL_optnumber(L, 2, 0));
+	lua_pushnumber(L, harvester->poll(limit));
+	return 1;
+}
+
+static int f_is_idle(lua_State* L)
+{
+	lua_pushboolean(L, check_harvester(L, 1)->isIdle());
+	return 1;
+}
+
+static int f_has_results(lua_State* L)
+{
+	lua_pushboolean(L, check_harvester(L, 1)->hasResults());
+	return 1;
+}
+
+static int f_complete(lua_State* L)
+{
+	auto harvester = check_harvester(L, 1);
+	size_t len;
+	auto prefix = luaL_checklstring(L, 2, &len);
+	auto limit = static_cast<size_t>(luaL_checknumber(L, 3));
+
+	auto results = harvester->complete({ prefix, len }, limit);
+	lua_createtable(L, results.size(), 0);
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		lua_pushlstring(L, results[i].data(), results[i].size());
+		lua_rawseti(L, -2, i + 1);
+	}
+	return 1;
+}
+
+// returns an array of { name = , filename = , line = }; filenames are
+// relative to the project root
+static int f_find_definitions(lua_State* L)
+{
+	auto harvester = check_harvester(L, 1);
+	size_t len;
+	auto query = luaL_checklstring(L, 2, &len);
+	auto limit = static_cast<size_t>(luaL_checknumber(L, 3));
+
+	auto matches = harvester->findDefinitions({ query, len }, limit);
+	lua_createtable(L, matches.size(), 0);
+	for (size_t i = 0; i < matches.size(); i++)
+	{
+		auto& definition = *matches[i].definition;
+		lua_createtable(L, 0, 3);
+		lua_pushlstring(L, definition.name.c_str(), definition.name.size());
+		lua_setfield(L, -2, "name");
+		lua_pushlstring(L, matches[i].fileName->c_str(), matches[i].fileName->size());
+		lua_setfield(L, -2, "filename");
+		lua_pushnumber(L, definition.line);
+		lua_setfield(L, -2, "line");
+		lua_rawseti(L, -2, i + 1);
+	}
+	return 1;
+}
+
+
+int InitializeSymbolHarvester(lua_State* L)
+{
+	const luaL_Reg lib[] =
+	{
+		{ "__gc",				f_gc				},
+		{ "__len",				f_len				},
+		{ "new",				f_new				},
+		{ "update",				f_update			},
+		{ "poll",				f_poll				},
+		{ "is_idle",			f_is_idle			},
+		{ "has_results",		f_has_results		},
+		{ "complete",			f_complete			},
+		{ "find_definitions",	f_find_definitions	},
+		{ NULL,					NULL				}
+	};
+
+	luaL_newmetatable(L, "SymbolHarvester");
+	luaL_setfuncs(L, lib, 0);
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+	return 1;
+}
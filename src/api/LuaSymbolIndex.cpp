@@ -0,0 +1,143 @@
+#include "ApiBridge.h"
+#include "../search/SymbolIndex.h"
+
+static SymbolIndex* check_index(lua_State* L, int idx)
+{
+	return *reinterpret_cast<SymbolIndex**>(luaL_checkudata(L, idx, "SymbolIndex"));
+}
+
+static int f_new(lua_State* L)
+{
+	auto self = reinterpret_cast<SymbolIndex**>(lua_newuserdata(L, sizeof(SymbolIndex*)));
+	*self = new SymbolIndex();
+	luaL_getmetatable(L, "SymbolIndex");
+	lua_setmetatable(L, -2);
+	return 1;
+}
+
+static int f_gc(lua_State* L)
+{
+	auto self = reinterpret_cast<SymbolIndex**>(luaL_checkudata(L, 1, "SymbolIndex"));
+	if (*self)
+	{
+		delete *self;
+		*self = nullptr;
+	}
+	return 0;
+}
+
+static int f_len(lua_State* L)
+{
+	lua_pushnumber(L, check_index(L, 1)->size());
+	return 1;
+}
+
+// index:splice(doc_id, line, removed, lines, added)
+// replaces `removed` lines from `line` with lines[line] .. lines[line + added - 1];
+// the lines are read straight from the doc's line table
+static int f_splice(lua_State* L)
+{
+	auto index = check_index(L, 1);
+	auto doc = static_cast<int>(luaL_checknumber(L, 2));
+	auto line = static_cast<size_t>(luaL_checknumber(L, 3));
+	auto removed = static_cast<size_t>(luaL_checknumber(L, 4));
+	luaL_checktype(L, 5, LUA_TTABLE);
+	auto added = static_cast<size_t>(luaL_checknumber(L, 6));
+	luaL_argcheck(L, line >= 1, 3, "line out of range");
+
+	std::vector<std::string_view> lines;
+	lines.reserve(added);
+	for (size_t i = 0; i < added; i++)
+	{
+		lua_rawgeti(L, 5, line + i);
+		size_t len;
+		auto text = lua_tolstring(L, -1, &len);
+		lines.emplace_back(text ? text : "", text ? len : 0);
+		// the string stays referenced by the table
+		lua_pop(L, 1);
+	}
+
+	index->splice(doc, line - 1, removed, lines);
+	return 0;
+}
+
+// index:splice_symbols(doc_id, line, removed, symbols)
+// like splice, with `symbols` holding one list of symbols per added line
+static int f_splice_symbols(lua_State* L)
+{
+	auto index = check_index(L, 1);
+	auto doc = static_cast<int>(luaL_checknumber(L, 2));
+	auto line = static_cast<size_t>(luaL_checknumber(L, 3));
+	auto removed = static_cast<size_t>(luaL_checknumber(L, 4));
+	luaL_checktype(L, 5, LUA_TTABLE);
+	luaL_argcheck(L, line >= 1, 3, "line out of range");
+
+	std::vector<std::vector<std::string_view>> added(lua_objlen(L, 5));
+	for (size_t i = 0; i < added.size(); i++)
+	{
+		lua_rawgeti(L, 5, i + 1);
+		if (lua_istable(L, -1))
+		{
+			auto count = lua_objlen(L, -1);
+			added[i].reserve(count);
+			for (size_t j = 1; j <= count; j++)
+			{
+				lua_rawgeti(L, -1, j);
+				size_t len;
+				auto text = lua_tolstring(L, -1, &len);
+				if (text) added[i].emplace_back(text, len);
+				// the string stays referenced by the table
+				lua_pop(L, 1);
+			}
+		}
+		lua_pop(L, 1);
+	}
+
+	index->spliceSymbols(doc, line - 1, removed, added);
+	return 0;
+}
+
+static int f_remove_doc(lua_State* L)
+{
+	check_index(L, 1)->removeDoc(static_cast<int>(luaL_checknumber(L, 2)));
+	return 0;
+}
+
+static int f_complete(lua_State* L)
+{
+	auto index = check_index(L, 1);
+	size_t len;
+	auto prefix = luaL_checklstring(L, 2, &len);
+	auto limit = static_cast<size_t>(luaL_checknumber(L, 3));
+
+	auto results = index->complete({ prefix, len }, limit);
+	lua_createtable(L, results.size(), 0);
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		lua_pushlstring(L, results[i].data(), results[i].size());
+		lua_rawseti(L, -2, i + 1);
+	}
+	return 1;
+}
+
+
+int InitializeSymbolIndex(lua_State* L)
+{
+	const luaL_Reg lib[] =
+	{
+		{ "__gc",			f_gc				},
+		{ "__len",			f_len				},
+		{ "new",			f_new				},
+		{ "splice",			f_splice			},
+		{ "splice_symbols",	f_splice_symbols	},
+		{ "remove_doc",		f_remove_doc		},
+		{ "complete",		f_complete			},
+		{ NULL,				NULL				}
+	};
+
+	luaL_newmetatable(L, "SymbolIndex");
+	luaL_setfuncs(L, lib, 0);
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+	return 1;
+}
@@ -1,8 +1,16 @@
 #include "ApiBridge.h"
+#include "../search/FuzzyMatcher.h"
+#include "../scheduler/Wakeup.h"
+#include "../io/AsyncIO.h"
+#include "../memory/LuaAllocator.h"
+#include "../process/Process.h"
+#include "../profiler/Profiler.h"
+#include "../worker/Worker.h"
 
 #include <stdbool.h>
 #include <ctype.h>
 #include <errno.h>
+#include <math.h>
 #include <sys/stat.h>
 #include <direct.h>
 #include <filesystem>
@@ -28,6 +36,10 @@ SDL_Window* window;
 extern Renderer* renderer;
 extern RenderCache* renderCache;
 
+extern int PushWorkerEvent(lua_State* L, const SDL_Event& e);
+extern int PushProcessEvent(lua_State* L, const SDL_Event& e);
+extern int PushFileEvent(lua_State* L, const SDL_Event& e);
+
 static const char* button_name(int button) {
     switch (button) {
     case 1: return "left";
@@ -49,13 +61,24 @@ static char* key_name(char* dst, int sym) {
 }
 
 
-static int f_poll_event(lua_State* L) {
+// pushes the values describing `e`; returns 0 for events Lua never sees
+static int push_event(lua_State* L, SDL_Event& e) {
     char buf[16];
     int mx, my, wx, wy;
-    SDL_Event e;
 
-top:
-    if (!SDL_PollEvent(&e)) {
+    if (e.type == Worker::getEventType()) {
+        return PushWorkerEvent(L, e);
+    }
+
+    if (e.type == Process::getEventType()) {
+        return PushProcessEvent(L, e);
+    }
+
+    if (e.type == AsyncIO::getEventType()) {
+        return PushFileEvent(L, e);
+    }
+
+    if (e.type == Wakeup::getEventType()) {
         return 0;
     }
 
@@ -76,13 +99,17 @@ top:
             lua_pushstring(L, "exposed");
             return 1;
         }
-        /* on some systems, when alt-tabbing to the window SDL will queue up
-        ** several KEYDOWN events for the `tab` key; we flush all keydown
-        ** events on focus so these are discarded */
+        /* keydown events queued behind this one were discarded when the
+        ** queue was drained, see f_poll_events */
         if (e.window.event == SDL_WINDOWEVENT_FOCUS_GAINED) {
-            SDL_FlushEvent(SDL_KEYDOWN);
+            lua_pushstring(L, "focusgained");
+            return 1;
+        }
+        else if (e.window.event == SDL_WINDOWEVENT_FOCUS_LOST) {
+            lua_pushstring(L, "focuslost");
+            return 1;
         }
-        goto top;
+        return 0;
 
     case SDL_DROPFILE:
         SDL_GetGlobalMouseState(&mx, &my);
@@ -144,16 +171,143 @@ top:
         return 2;
 
     default:
-        goto top;
+        return 0;
+    }
+
+    return 0;
+}
+
+
+// the moment SDL received `e`, on the `system.get_time` clock
+static double event_time(const SDL_Event& e) {
+    double now = SDL_GetPerformanceCounter() / (double)SDL_GetPerformanceFrequency();
+    return now - (Uint32)(SDL_GetTicks() - e.common.timestamp) / 1000.0;
+}
+
+
+// starts the input-to-photon clock for input which is expected to show
+static void track_latency(const SDL_Event& e, double time) {
+    switch (e.type) {
+    case SDL_KEYDOWN:
+    case SDL_TEXTINPUT:
+        renderCache->getLatency().input(LATENCY_KEY, time);
+        break;
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEWHEEL:
+        renderCache->getLatency().input(LATENCY_POINTER, time);
+        break;
     }
+}
+
 
+static int f_poll_event(lua_State* L) {
+    SDL_Event e;
+    while (SDL_PollEvent(&e)) {
+        int n = push_event(L, e);
+        if (n > 0) {
+            track_latency(e, event_time(e));
+            return n;
+        }
+    }
     return 0;
 }
 
 
+// merges `e` into `last` if both are mouse motion or both wheel turns, so
+// a burst of either costs one Lua event
+static bool merge_event(SDL_Event& last, const SDL_Event& e) {
+    if (last.type != e.type) { return false; }
+    if (e.type == SDL_MOUSEMOTION) {
+        last.motion.x = e.motion.x;
+        last.motion.y = e.motion.y;
+        last.motion.xrel += e.motion.xrel;
+        last.motion.yrel += e.motion.yrel;
+        return true;
+    }
+    if (e.type == SDL_MOUSEWHEEL) {
+        last.wheel.x += e.wheel.x;
+        last.wheel.y += e.wheel.y;
+        return true;
+    }
+    return false;
+}
+
+
+static const char* event_fields[] = { "a", "b", "c", "d" };
+
+// system.poll_events(t): drains the event queue into `t`, reusing the
+// tables already in it; each event is { type, a, b, c, d, time } with
+// `time` the moment SDL received it on the `system.get_time` clock, that
+// of the first event for merged ones. Returns the number of events.
+static int f_poll_events(lua_State* L) {
+    static std::vector<SDL_Event> events;
+    luaL_checktype(L, 1, LUA_TTABLE);
+
+    events.clear();
+    SDL_Event e;
+    bool focusGained = false;
+    while (SDL_PollEvent(&e)) {
+        /* on some systems, when alt-tabbing to the window SDL will queue up
+        ** several KEYDOWN events for the `tab` key; we drop all keydown
+        ** events which follow a focus gain so these are discarded */
+        if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_FOCUS_GAINED) {
+            SDL_FlushEvent(SDL_KEYDOWN);
+            focusGained = true;
+        }
+        else if (e.type == SDL_KEYDOWN && focusGained) {
+            continue;
+        }
+        if (events.empty() || !merge_event(events.back(), e)) {
+            events.push_back(e);
+        }
+    }
+
+    int count = 0;
+    for (auto& event : events) {
+        int top = lua_gettop(L);
+        int n = push_event(L, event);
+        if (n == 0) { continue; }
+
+        double time = event_time(event);
+        track_latency(event, time);
+        count++;
+        lua_rawgeti(L, 1, count);
+        if (!lua_istable(L, -1)) {
+            lua_pop(L, 1);
+            lua_createtable(L, 0, 6);
+            lua_pushvalue(L, -1);
+            lua_rawseti(L, 1, count);
+        }
+        int record = lua_gettop(L);
+
+        lua_pushvalue(L, top + 1);
+        lua_setfield(L, record, "type");
+        for (int i = 0; i < 4; i++) {
+            if (i + 2 <= n) {
+                lua_pushvalue(L, top + 2 + i);
+            } else {
+                lua_pushnil(L);
+            }
+            lua_setfield(L, record, event_fields[i]);
+        }
+        lua_pushnumber(L, time);
+        lua_setfield(L, record, "time");
+        lua_settop(L, top);
+    }
+
+    lua_pushnumber(L, count);
+    return 1;
+}
+
+
 static int f_wait_event(lua_State* L) {
+    ProfileZone zone(Profiler::IDLE);
+    if (lua_isnoneornil(L, 1)) {
+        lua_pushboolean(L, SDL_WaitEvent(NULL));
+        return 1;
+    }
     double n = luaL_checknumber(L, 1);
-    lua_pushboolean(L, SDL_WaitEventTimeout(NULL, n * 1000));
+    lua_pushboolean(L, SDL_WaitEventTimeout(NULL, (int)ceil(n * 1000)));
     return 1;
 }
 
@@ -197,6 +351,19 @@ static int f_set_window_title(lua_State* L) {
 }
 
 
+// system.set_window_size(w, h): returns the size the window ended up
+// with, which the window manager may have overridden
+static int f_set_window_size(lua_State* L) {
+    int w = static_cast<int>(luaL_checknumber(L, 1));
+    int h = static_cast<int>(luaL_checknumber(L, 2));
+    SDL_SetWindowSize(window, w, h);
+    SDL_GetWindowSize(window, &w, &h);
+    lua_pushnumber(L, w);
+    lua_pushnumber(L, h);
+    return 2;
+}
+
+
 static const char* window_opts[] = { "normal", "maximized", "fullscreen", 0 };
 enum { WIN_NORMAL, WIN_MAXIMIZED, WIN_FULLSCREEN };
 
@@ -217,6 +384,81 @@ static int f_window_has_focus(lua_State* L) {
 }
 
 
+static int f_get_refresh_rate(lua_State* L) {
+    SDL_DisplayMode mode;
+    int display = SDL_GetWindowDisplayIndex(window);
+    if (display < 0 || SDL_GetCurrentDisplayMode(display, &mode) != 0 || mode.refresh_rate <= 0) {
+        lua_pushnil(L);
+        return 1;
+    }
+    lua_pushnumber(L, mode.refresh_rate);
+    return 1;
+}
+
+
+static void set_number_field(lua_State* L, const char* name, double value) {
+    lua_pushnumber(L, value);
+    lua_setfield(L, -2, name);
+}
+
+// system.memory_stats(): bytes held by the Lua heap, the fonts, the render
+// cache and the window surface; the allocation counts are only there when
+// the Lua state allocates through LuaAllocator, the pool's when it uses one
+static int f_memory_stats(lua_State* L) {
+    lua_newtable(L);
+
+    size_t luaHeap = static_cast<size_t>(lua_gc(L, LUA_GCCOUNT, 0)) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
+    set_number_field(L, "lua_heap", static_cast<double>(luaHeap));
+    auto pool = LuaAllocator::getPool(L);
+    lua_pushstring(L, pool ? "pool" : LuaAllocator::isUsedBy(L) ? "malloc" : "default");
+    lua_setfield(L, -2, "lua_allocator");
+    if (LuaAllocator::isUsedBy(L)) {
+        auto& stats = LuaAllocator::getStats();
+        set_number_field(L, "lua_peak", static_cast<double>(stats.peakBytes));
+        set_number_field(L, "lua_allocations", static_cast<double>(stats.allocations));
+        set_number_field(L, "lua_frees", static_cast<double>(stats.frees));
+        set_number_field(L, "frame_allocations", static_cast<double>(stats.frameAllocations));
+        set_number_field(L, "frame_bytes", static_cast<double>(stats.frameBytes));
+    }
+    if (pool) {
+        auto& stats = pool->getStats();
+        set_number_field(L, "pool_arenas", static_cast<double>(stats.arenas));
+        set_number_field(L, "pool_arena_bytes", static_cast<double>(stats.arenaBytes));
+        set_number_field(L, "pool_block_bytes", static_cast<double>(stats.blockBytes));
+        set_number_field(L, "pool_requested_bytes", static_cast<double>(stats.requestedBytes));
+        set_number_field(L, "pool_free_bytes", static_cast<double>(stats.freeBytes));
+        set_number_field(L, "pool_allocations", static_cast<double>(stats.pooled));
+        set_number_field(L, "pool_large_allocations", static_cast<double>(stats.large));
+    }
+
+    size_t fontData = 0, glyphs = 0;
+    auto& fonts = renderer->getFonts();
+    lua_createtable(L, static_cast<int>(fonts.size()), 0);
+    for (size_t i = 0; i < fonts.size(); i++) {
+        auto font = fonts[i];
+        auto glyphBytes = renderer->getFontGlyphBytes(font);
+        fontData += font->dataSize;
+        glyphs += glyphBytes;
+
+        lua_createtable(L, 0, 4);
+        lua_pushstring(L, font->fileName.c_str());
+        lua_setfield(L, -2, "filename");
+        set_number_field(L, "size", font->size);
+        set_number_field(L, "data", static_cast<double>(font->dataSize));
+        set_number_field(L, "glyphs", static_cast<double>(glyphBytes));
+        lua_rawseti(L, -2, static_cast<int>(i + 1));
+    }
+    lua_setfield(L, -2, "fonts");
+    set_number_field(L, "font_data", static_cast<double>(fontData));
+    set_number_field(L, "glyphs", static_cast<double>(glyphs));
+
+    set_number_field(L, "command_buffer", COMMAND_BUF_SIZE);
+    set_number_field(L, "command_buffer_peak", renderCache->getCommandBufferPeak());
+    set_number_field(L, "surface", static_cast<double>(renderer->getSurfaceBytes()));
+    return 1;
+}
+
+
 static int f_show_confirm_dialog(lua_State* L) {
     const char* title = luaL_checkstring(L, 1);
     const char* msg = luaL_checkstring(L, 2);
@@ -274,6 +516,17 @@ static int f_list_dir(lua_State* L)
     return 1;
 }
 
+// system.mkdir(path): creates `path` and any missing parents; returns true
+// if it exists afterwards
+static int f_mkdir(lua_State* L)
+{
+    auto path = luaL_checkstring(L, 1);
+    std::error_code ec;
+    std::filesystem::create_directories(path, ec);
+    lua_pushboolean(L, std::filesystem::is_directory(path, ec));
+    return 1;
+}
+
 #ifdef _WIN32
 #include <windows.h>
 #define realpath(x, y) _fullpath(y, x, MAX_PATH)
@@ -346,6 +599,7 @@ static int f_get_time(lua_State* L) {
 
 
 static int f_sleep(lua_State* L) {
+    ProfileZone zone(Profiler::IDLE);
     double n = luaL_checknumber(L, 1);
     SDL_Delay(n * 1000);
     return 0;
@@ -371,44 +625,68 @@ static int f_exec(lua_State* L) {
 
 
 static int f_fuzzy_match(lua_State* L) {
-    const char* str = luaL_checkstring(L, 1);
-    const char* ptn = luaL_checkstring(L, 2);
-    int score = 0;
-    int run = 0;
-
-    while (*str && *ptn) {
-        while (*str == ' ') { str++; }
-        while (*ptn == ' ') { ptn++; }
-        if (tolower(*str) == tolower(*ptn)) {
-            score += run * 10 - (*str != *ptn);
-            run++;
-            ptn++;
-        }
-        else {
-            score -= 10;
-            run = 0;
-        }
-        str++;
-    }
-    if (*ptn) { return 0; }
+    size_t strLen, ptnLen;
+    const char* str = luaL_checklstring(L, 1, &strLen);
+    const char* ptn = luaL_checklstring(L, 2, &ptnLen);
+    int score;
+
+    if (!FuzzyMatcher::score({ str, strLen }, { ptn, ptnLen }, score)) { return 0; }
+
+    lua_pushnumber(L, score);
+    return 1;
+}
+
 
-    lua_pushnumber(L, score - (int)strlen(str));
+static int f_fuzzy_match_list(lua_State* L) {
+    size_t ptnLen;
+    const char* ptn = luaL_checklstring(L, 2, &ptnLen);
+    auto limit = static_cast<size_t>(luaL_optnumber(L, 3, 0));
+
+    std::vector<std::string_view> items;
+    ApiBridge::CheckStringList(L, 1, items);
+    auto matches = FuzzyMatcher::matchList(items, { ptn, ptnLen }, limit);
+
+    lua_createtable(L, matches.size(), 0);
+    int i = 1;
+    for (auto& match : matches) {
+        lua_rawgeti(L, 1, match.index + 1);
+        lua_rawseti(L, -2, i++);
+    }
     return 1;
 }
 
+
+extern int InitializeFuzzySession(lua_State* L);
+extern int InitializeProjectScan(lua_State* L);
+extern int InitializeProjectTree(lua_State* L);
+extern int InitializeDirLister(lua_State* L);
+extern int InitializeTreeModel(lua_State* L);
+extern int InitializeSymbolIndex(lua_State* L);
+extern int InitializeSymbolHarvester(lua_State* L);
+extern int InitializeWorker(lua_State* L);
+extern int InitializeScheduler(lua_State* L);
+extern int InitializeProcess(lua_State* L);
+extern int InitializeAsyncIO(lua_State* L);
+extern int InitializeProfiler(lua_State* L);
+extern int InitializeStartupTrace(lua_State* L);
 int InitializeSystem(lua_State* L)
 {
 	const luaL_Reg lib[] =
 	{
 		{ "poll_event",          f_poll_event          },
+		{ "poll_events",         f_poll_events         },
 		{ "wait_event",          f_wait_event          },
 		{ "set_cursor",          f_set_cursor          },
 		{ "set_window_title",    f_set_window_title    },
 		{ "set_window_mode",     f_set_window_mode     },
+		{ "set_window_size",     f_set_window_size     },
 		{ "window_has_focus",    f_window_has_focus    },
+		{ "get_refresh_rate",    f_get_refresh_rate    },
+		{ "memory_stats",        f_memory_stats        },
 		{ "show_confirm_dialog", f_show_confirm_dialog },
 		{ "chdir",               f_chdir               },
 		{ "list_dir",            f_list_dir            },
+		{ "mkdir",               f_mkdir               },
 		{ "absolute_path",       f_absolute_path       },
 		{ "get_file_info",       f_get_file_info       },
 		{ "get_clipboard",       f_get_clipboard       },
@@ -417,9 +695,36 @@ int InitializeSystem(lua_State* L)
 		{ "sleep",               f_sleep               },
 		{ "exec",                f_exec                },
 		{ "fuzzy_match",         f_fuzzy_match         },
+		{ "fuzzy_match_list",    f_fuzzy_match_list    },
 		{ NULL, NULL }
 	};
 
 	luaL_newlib(L, lib);
+	InitializeFuzzySession(L);
+	lua_setfield(L, -2, "fuzzy_session");
+	InitializeProjectScan(L);
+	lua_setfield(L, -2, "project_scan");
+	InitializeProjectTree(L);
+	lua_setfield(L, -2, "project_tree");
+	InitializeDirLister(L);
+	lua_setfield(L, -2, "dir_lister");
+	InitializeTreeModel(L);
+	lua_setfield(L, -2, "tree_model");
+	InitializeSymbolIndex(L);
+	lua_setfield(L, -2, "symbol_index");
+	InitializeSymbolHarvester(L);
+	lua_setfield(L, -2, "symbol_harvester");
+	InitializeWorker(L);
+	lua_setfield(L, -2, "spawn_worker");
+	InitializeScheduler(L);
+	lua_setfield(L, -2, "scheduler");
+	InitializeProcess(L);
+	lua_setfield(L, -2, "start_process");
+	InitializeAsyncIO(L);
+	lua_setfield(L, -2, "async_file");
+	InitializeProfiler(L);
+	lua_setfield(L, -2, "profiler");
+	InitializeStartupTrace(L);
+	lua_setfield(L, -2, "startup_trace");
 	return 1;
 }
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "ApiBridge.h"
+#include "../project/DirLister.h"
+#include "../project/TreeModel.h"
+
+struct LuaTreeModel
+{
+	TreeModel* model;
+	int treeRef;
+};
+
+static LuaTreeModel* check_model(lua_State* L, int idx)
+{
+	return reinterpret_cast<LuaTreeModel*>(luaL_checkudata(L, idx, "TreeModel"));
+}
+
+// converts a 1-based Lua row into a model row
+static size_t check_row(lua_State* L, TreeModel* model, int idx)
+{
+	auto row = static_cast<size_t>(luaL_checknumber(L, idx));
+	luaL_argcheck(L, row >= 1 && row <= model->getRowCount(), idx, "row out of range");
+	return row - 1;
+}
+
+static int f_new(lua_State* L)
+{
+	auto self = reinterpret_cast<LuaTreeModel*>(lua_newuserdata(L, sizeof(LuaTreeModel)));
+	self->model = new TreeModel();
+	self->treeRef = LUA_NOREF;
+	luaL_getmetatable(L, "TreeModel");
+	lua_setmetatable(L, -2);
+	return 1;
+}
+
+static int f_gc(lua_State* L)
+{
+	auto self = check_model(L, 1);
+	if (self->model)
+	{
+		luaL_unref(L, LUA_REGISTRYINDEX, self->treeRef);
+		delete self->model;
+		self->model = nullptr;
+	}
+	return 0;
+}
+
+static int f_len(lua_State* L)
+{
+	lua_pushnumber(L, check_model(L, 1)->model->getRowCount());
+	return 1;
+}
+
+static int f_set_tree(lua_State* L)
+{
+	auto self = check_model(L, 1);
+	auto tree = *reinterpret_cast<ProjectTree**>(luaL_checkudata(L, 2, "ProjectTree"));
+
+	// the tree belongs to its Lua object, which is kept alive while in use
+	luaL_unref(L, LUA_REGISTRYINDEX, self->treeRef);
+	lua_pushvalue(L, 2);
+	self->treeRef = luaL_ref(L, LUA_REGISTRYINDEX);
+	self->model->setTree(tree);
+	return 0;
+}
+
+// moves finished listings from a DirLister into the model; returns true if
+// any arrived
+static int f_poll(lua_State* L)
+{
+	auto self = check_model(L, 1);
+	auto lister = *reinterpret_cast<DirLister**>(luaL_checkudata(L, 2, "DirLister"));
+
+	std::string relPath;
+	DirListing listing;
+	while (lister->poll(relPath, listing))
+	{
+		self->model->setListing(lister->getRoot(), relPath, std::move(listing));
+	}
+
+	bool changed = self->model->applyListings();
+	if (changed)
+	{
+		luaL_unref(L, LUA_REGISTRYINDEX, self->treeRef);
+		self->treeRef = LUA_NOREF;
+	}
+	lua_pushboolean(L, changed);
+	return 1;
+}
+
+static int f_get_item(lua_State* L)
+{
+	auto model = check_model(L, 1)->model;
+	auto row = check_row(L, model, 2);
+	auto& tree = model->getTree();
+	auto idx = model->getNodeIndex(row);
+	auto& node = tree.getNode(idx);
+	auto& name = tree.getName(idx);
+	lua_pushlstring(L, name.c_str(), name.size());
+	lua_pushstring(L, node.isDir ? "dir" : "file");
+	lua_pushnumber(L, node.depth);
+	lua_pushboolean(L, model->isExpanded(row));
+	return 4;
+}
+
+static int f_get_filename(lua_State* L)
+{
+	auto model = check_model(L, 1)->model;
+	auto fileName = model->getTree().getFileName(model->getNodeIndex(check_row(L, model, 2)));
+	lua_pushlstring(L, fileName.c_str(), fileName.size());
+	return 1;
+}
+
+// relative path with "/" separators, as DirLister expects
+static int f_get_path(lua_State* L)
+{
+	auto model = check_model(L, 1)->model;
+	auto path = model->getTree().getRelativePath(model->getNodeIndex(check_row(L, model, 2)), '/');
+	lua_pushlstring(L, path.c_str(), path.size());
+	return 1;
+}
+
+static int f_is_expanded(lua_State* L)
+{
+	auto model = check_model(L, 1)->model;
+	lua_pushboolean(L, model->isExpanded(check_row(L, model, 2)));
+	return 1;
+}
+
+static int f_set_expanded(lua_State* L)
+{
+	auto model = check_model(L, 1)->model;
+	model->setExpanded(check_row(L, model, 2), lua_toboolean(L, 3));
+	return 0;
+}
+
+static int f_get_expanded(lua_State* L)
+{
+	auto paths = check_model(L, 1)->model->getExpandedPaths();
+	lua_createtable(L, paths.size(), 0);
+	for (size_t i = 0; i < paths.size(); i++)
+	{
+		lua_pushlstring(L, paths[i].c_str(), paths[i].size());
+		lua_rawseti(L, -2, i + 1);
+	}
+	return 1;
+}
+
+static int f_find_row(lua_State* L)
+{
+	auto model = check_model(L, 1)->model;
+	size_t len;
+	auto path = luaL_checklstring(L, 2, &len);
+	auto row = model->findRow({ path, len });
+	if (row < 0) return 0;
+	lua_pushnumber(L, static_cast<lua_Number>(row + 1));
+	return 1;
+}
+
+
+int InitializeTreeModel(lua_State* L)
+{
+	const luaL_Reg lib[] =
+	{
+		{ "__gc",			f_gc			},
+		{ "__len",			f_len			},
+		{ "new",			f_new			},
+		{ "set_tree",		f_set_tree		},
+		{ "poll",			f_poll			},
+		{ "get_item",		f_get_item		},
+		{ "get_filename",	f_get_filename	},
+		{ "get_path",		f_get_path		},
+		{ "is_expanded",	f_is_expanded	},
+		{ "set_expanded",	f_set_expanded	},
+		{ "get_expanded",	f_get_expanded	},
+		{ "find_row",		f_find_row		},
+		{ NULL,				NULL			}
+	};
+
+	luaL_newmetatable(L, "TreeModel");
+	luaL_setfuncs(L, lib, 0);
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+	return 1;
+}
@@ -0,0 +1,141 @@
+#include "ApiBridge.h"
+#include "../worker/Worker.h"
+
+static Worker* check_worker(lua_State* L, int idx)
+{
+	auto self = reinterpret_cast<Worker**>(luaL_checkudata(L, idx, "Worker"));
+	if (!*self) luaL_error(L, "worker was destroyed");
+	return *self;
+}
+
+static std::string get_global_string(lua_State* L, const char* table, const char* field)
+{
+	lua_getglobal(L, table);
+	if (field)
+	{
+		lua_getfield(L, -1, field);
+		lua_remove(L, -2);
+	}
+	std::string value = lua_isstring(L, -1) ? lua_tostring(L, -1) : "";
+	lua_pop(L, 1);
+	return value;
+}
+
+// system.spawn_worker(module, ...): runs the function returned by `module`
+// on a new thread with a copy of the remaining arguments
+static int f_spawn_worker(lua_State* L)
+{
+	std::string module = luaL_checkstring(L, 1);
+
+	std::vector<WorkerValue> args;
+	std::string error;
+	if (!WorkerValue::fromLuaArgs(L, 2, args, error)) return luaL_error(L, "%s", error.c_str());
+
+	WorkerEnvironment environment;
+	environment.packagePath = get_global_string(L, "package", "path");
+	environment.packageCPath = get_global_string(L, "package", "cpath");
+	environment.exeDir = get_global_string(L, "EXEDIR", nullptr);
+
+	auto self = reinterpret_cast<Worker**>(lua_newuserdata(L, sizeof(Worker*)));
+	*self = new Worker(module, std::move(args), environment);
+	luaL_getmetatable(L, "Worker");
+	lua_setmetatable(L, -2);
+	return 1;
+}
+
+// stops the worker and waits for it to finish
+static int f_gc(lua_State* L)
+{
+	auto self = reinterpret_cast<Worker**>(luaL_checkudata(L, 1, "Worker"));
+	if (*self)
+	{
+		delete *self;
+		*self = nullptr;
+	}
+	return 0;
+}
+
+static int f_send(lua_State* L)
+{
+	auto worker = check_worker(L, 1);
+	std::vector<WorkerValue> values;
+	std::string error;
+	if (!WorkerValue::fromLuaArgs(L, 2, values, error)) return luaL_error(L, "%s", error.c_str());
+	worker->send(std::move(values));
+	return 0;
+}
+
+static int f_stop(lua_State* L)
+{
+	check_worker(L, 1)->stop();
+	return 0;
+}
+
+static int f_is_running(lua_State* L)
+{
+	lua_pushboolean(L, check_worker(L, 1)->isRunning());
+	return 1;
+}
+
+static int f_get_id(lua_State* L)
+{
+	lua_pushnumber(L, check_worker(L, 1)->getId());
+	return 1;
+}
+
+static void push_values(lua_State* L, const std::vector<WorkerValue>& values)
+{
+	lua_createtable(L, static_cast<int>(values.size()), 1);
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		values[i].push(L);
+		lua_rawseti(L, -2, static_cast<int>(i + 1));
+	}
+	lua_pushnumber(L, static_cast<lua_Number>(values.size()));
+	lua_setfield(L, -2, "n");
+}
+
+// turns a worker event from system.poll_event into
+// "workermessage", id, { ... } or "workerdone", id, ok, { ... };
+// returns 0 if the worker is gone
+int PushWorkerEvent(lua_State* L, const SDL_Event& e)
+{
+	auto worker = Worker::find(static_cast<uint32_t>(e.user.code));
+	WorkerMessage message;
+	if (!worker || !worker->receive(message)) return 0;
+
+	lua_pushstring(L, message.done ? "workerdone" : "workermessage");
+	lua_pushnumber(L, worker->getId());
+	if (message.done)
+	{
+		lua_pushboolean(L, message.ok);
+		push_values(L, message.values);
+		return 4;
+	}
+	push_values(L, message.values);
+	return 3;
+}
+
+
+int InitializeWorker(lua_State* L)
+{
+	const luaL_Reg lib[] =
+	{
+		{ "__gc",			f_gc			},
+		{ "send",			f_send			},
+		{ "stop",			f_stop			},
+		{ "is_running",		f_is_running	},
+		{ "get_id",			f_get_id		},
+		{ NULL,				NULL			}
+	};
+
+	luaL_newmetatable(L, "Worker");
+	luaL_setfuncs(L, lib, 0);
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+	lua_pop(L, 1);
+
+	Worker::getEventType();
+	lua_pushcfunction(L, f_spawn_worker);
+	return 1;
+}
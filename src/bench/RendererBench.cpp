@@ -0,0 +1,168 @@
+/**
+ * File Name: RendererBench.cpp
+ *
+ * luaxt_bench: renderer micro-benchmarks on an in-memory surface
+ *
+ * usage: luaxt_bench [--font path] [--filter text] [--min-time seconds]
+ *
+ * Prints one JSON object with the time per operation of each benchmark.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+
+#include "../rendering/RenderCache.h"
+#include "../rendering/Renderer.h"
+
+#define BENCH_WIDTH 1920
+#define BENCH_HEIGHT 1080
+#define BENCH_FONT_SIZE 14
+
+struct BenchResult
+{
+    std::string name;
+    uint64_t iterations;
+    double seconds;
+};
+
+static double now()
+{
+    return SDL_GetPerformanceCounter() / (double)SDL_GetPerformanceFrequency();
+}
+
+// runs `fn` in growing batches until a batch takes at least `minTime`
+static BenchResult measure(const char* name, double minTime, const std::function<void()>& fn)
+{
+    fn();
+
+    uint64_t iterations = 1;
+    while (true)
+    {
+        auto start = now();
+        for (uint64_t i = 0; i < iterations; i++) fn();
+        auto elapsed = now() - start;
+
+        if (elapsed >= minTime) return BenchResult{ name, iterations, elapsed };
+        auto scale = elapsed > 0 ? minTime / elapsed * 1.2 : 10;
+        iterations = static_cast<uint64_t>(iterations * (scale < 10 ? scale : 10)) + 1;
+    }
+}
+
+// drops every baked glyph set of `font` so the next use bakes it again
+static void dropGlyphsets(Renderer& renderer, RenFont* font)
+{
+    for (auto i = 0; i < MAX_GLYPHSET; i++)
+    {
+        if (!font->sets[i]) continue;
+        renderer.freeImage(font->sets[i]->image);
+        delete font->sets[i];
+        font->sets[i] = nullptr;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string fontPath = "data/fonts/font.ttf";
+    const char* filter = nullptr;
+    double minTime = 0.25;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--font") == 0) fontPath = argv[i + 1];
+        else if (strcmp(argv[i], "--filter") == 0) filter = argv[i + 1];
+        else if (strcmp(argv[i], "--min-time") == 0) minTime = atof(argv[i + 1]);
+    }
+
+    auto surface = SDL_CreateRGBSurfaceWithFormat(0, BENCH_WIDTH, BENCH_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (!surface)
+    {
+        fprintf(stderr, "could not create surface: %s\n", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+
+    Renderer renderer(surface);
+    RenderCache renderCache(renderer);
+    auto font = renderer.loadFont(fontPath, BENCH_FONT_SIZE);
+    if (!font)
+    {
+        fprintf(stderr, "could not load font %s\n", fontPath.c_str());
+        return EXIT_FAILURE;
+    }
+
+    const std::string ascii = "local function update(self) return self.x + 1 end -- comment";
+    const std::string cjk = "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\xe3\x81\xae\xe3\x83\x86\xe3\x82\xad\xe3\x82\xb9\xe3\x83\x88\xe4\xb8\xad\xe6\x96\x87\xe6\x96\x87\xe6\x9c\xac\xed\x95\x9c\xea\xb5\xad\xec\x96\xb4";
+    const std::string mixed = "name = \"\xe6\x97\xa5\xe6\x9c\xac\" -- caf\xc3\xa9 \xce\xbb x \xe2\x86\x92 y";
+
+    RenColor opaque{ 40, 50, 60, 255 };
+    RenColor blended{ 200, 100, 50, 128 };
+
+    auto image = renderer.newImage(64, 64);
+    memset(image->pixels, 0x80, sizeof(RenColor) * 64 * 64);
+
+    std::vector<std::pair<const char*, std::function<void()>>> benchmarks =
+    {
+        { "draw_rect_opaque", [&] { renderer.DrawRect(RenRect{ 100, 100, 400, 20 }, opaque); } },
+        { "draw_rect_blended", [&] { renderer.DrawRect(RenRect{ 100, 100, 400, 20 }, blended); } },
+        { "draw_image", [&] {
+            RenRect sub{ 0, 0, 64, 64 };
+            renderer.DrawImage(image, &sub, 200, 200, opaque);
+        } },
+        { "draw_text_ascii", [&] { renderer.DrawText(font, ascii, 10, 300, opaque); } },
+        { "draw_text_cjk", [&] { renderer.DrawText(font, cjk, 10, 320, opaque); } },
+        { "draw_text_mixed", [&] { renderer.DrawText(font, mixed, 10, 340, opaque); } },
+        { "font_width_ascii", [&] { renderer.getFontWidth(font, ascii); } },
+        { "font_width_cjk", [&] { renderer.getFontWidth(font, cjk); } },
+        { "font_width_mixed", [&] { renderer.getFontWidth(font, mixed); } },
+        { "glyphset_bake", [&] {
+            dropGlyphsets(renderer, font);
+            renderer.getFontWidth(font, "a");
+        } },
+
+        // a screen of text lines which stays the same, so the cache finds
+        // nothing to redraw
+        { "end_frame_static", [&] {
+            renderCache.beginFrame();
+            renderCache.drawRect(RenRect{ 0, 0, BENCH_WIDTH, BENCH_HEIGHT }, opaque);
+            for (int y = 0; y < BENCH_HEIGHT; y += 18)
+                renderCache.drawText(font, ascii, 10, y, blended);
+            renderCache.endFrame();
+        } },
+
+        // the same screen scrolled by a line every frame, so every cell
+        // is redrawn
+        { "end_frame_scrolling", [&] {
+            static int offset = 0;
+            offset = (offset + 1) % 18;
+            renderCache.beginFrame();
+            renderCache.drawRect(RenRect{ 0, 0, BENCH_WIDTH, BENCH_HEIGHT }, opaque);
+            for (int y = -offset; y < BENCH_HEIGHT; y += 18)
+                renderCache.drawText(font, ascii, 10, y, blended);
+            renderCache.endFrame();
+        } },
+    };
+
+    printf("{\n  \"surface\": [%d, %d],\n  \"font\": \"%s\",\n  \"benchmarks\": [", BENCH_WIDTH, BENCH_HEIGHT, fontPath.c_str());
+    bool first = true;
+    for (auto& [name, fn] : benchmarks)
+    {
+        if (filter && !strstr(name, filter)) continue;
+
+        auto result = measure(name, minTime, fn);
+        auto ns = result.seconds * 1e9 / result.iterations;
+        printf("%s\n    { \"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.1f, \"ops_per_sec\": %.1f }",
+            first ? "" : ",", result.name.c_str(), (unsigned long long)result.iterations, ns, 1e9 / ns);
+        fflush(stdout);
+        first = false;
+    }
+    printf("\n  ]\n}\n");
+
+    renderer.freeImage(image);
+    renderer.freeFont(font);
+    SDL_FreeSurface(surface);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,133 @@
+#include "AsyncIO.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <SDL.h>
+
+#define ASYNC_IO_CHUNK 65536
+
+uint32_t AsyncIO::eventType = 0;
+
+
+AsyncIO::AsyncIO() : stopping(false), nextId(1)
+{
+}
+
+AsyncIO::~AsyncIO()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    for (auto& thread : threads) thread.join();
+}
+
+AsyncIO& AsyncIO::get()
+{
+    static AsyncIO instance;
+    return instance;
+}
+
+uint32_t AsyncIO::getEventType()
+{
+    if (eventType == 0) eventType = SDL_RegisterEvents(1);
+    return eventType;
+}
+
+std::shared_ptr<FileRequest> AsyncIO::read(const std::string& path)
+{
+    auto request = std::make_shared<FileRequest>();
+    request->type = FileRequest::READ;
+    request->path = path;
+    submit(request);
+    return request;
+}
+
+std::shared_ptr<FileRequest> AsyncIO::write(const std::string& path, std::string&& data)
+{
+    auto request = std::make_shared<FileRequest>();
+    request->type = FileRequest::WRITE;
+    request->path = path;
+    request->data = std::move(data);
+    submit(request);
+    return request;
+}
+
+void AsyncIO::submit(const std::shared_ptr<FileRequest>& request)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        request->id = nextId++;
+        queue.push_back(request);
+
+        // threads start with the first requests, so an editor which never
+        // uses the pool pays nothing for it
+        if (threads.size() < ASYNC_IO_THREADS && threads.size() < queue.size())
+            threads.emplace_back(&AsyncIO::run, this);
+    }
+    condition.notify_one();
+}
+
+void AsyncIO::run()
+{
+    while (true)
+    {
+        std::shared_ptr<FileRequest> request;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping) return;
+            request = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        if (request->cancelled)
+            request->error = "cancelled";
+        else
+            process(*request);
+        request->done = true;
+
+        SDL_Event e;
+        SDL_zero(e);
+        e.type = eventType;
+        e.user.code = static_cast<Sint32>(request->id);
+        // the waiting thread only resumes on this event, so it must not be
+        // lost to a full queue
+        while (SDL_PushEvent(&e) <= 0 && !stopping) SDL_Delay(10);
+    }
+}
+
+void AsyncIO::process(FileRequest& request)
+{
+    auto fail = [&](FILE* fp)
+    {
+        request.error = request.path + ": " + strerror(errno);
+        request.data.clear();
+        if (fp) fclose(fp);
+    };
+
+    if (request.type == FileRequest::READ)
+    {
+        FILE* fp = fopen(request.path.c_str(), "rb");
+        if (!fp) return fail(nullptr);
+
+        char buffer[ASYNC_IO_CHUNK];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+        {
+            request.data.append(buffer, n);
+            if (request.cancelled) break;
+        }
+        if (ferror(fp)) return fail(fp);
+        fclose(fp);
+        return;
+    }
+
+    FILE* fp = fopen(request.path.c_str(), "wb");
+    if (!fp) return fail(nullptr);
+    if (fwrite(request.data.data(), 1, request.data.size(), fp) != request.data.size()) return fail(fp);
+    request.data.clear();
+    if (fclose(fp) != 0) return fail(nullptr);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// blocking file calls run on this many threads, so one slow file does not
+// hold up the others
+#define ASYNC_IO_THREADS 4
+
+struct FileRequest
+{
+    enum Type
+    {
+        READ,
+        WRITE
+    };
+
+    Type type;
+    uint32_t id;
+    std::string path;
+
+    // the data to write, or the data read once done
+    std::string data;
+
+    // set if the request failed, once done
+    std::string error;
+
+    std::atomic<bool> done{ false };
+    std::atomic<bool> cancelled{ false };
+};
+
+// Reads and writes whole files on a small pool of threads. The main thread
+// holds the request, and learns it is done through an SDL event carrying
+// its id, so completions arrive through the normal event loop.
+class AsyncIO
+{
+private:
+    static uint32_t eventType;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::shared_ptr<FileRequest>> queue;
+    std::vector<std::thread> threads;
+    // read unlocked by workers waiting to push a completion event
+    std::atomic<bool> stopping;
+    uint32_t nextId;
+
+    void run();
+    void submit(const std::shared_ptr<FileRequest>& request);
+    static void process(FileRequest& request);
+
+public:
+    AsyncIO();
+    ~AsyncIO();
+
+    std::shared_ptr<FileRequest> read(const std::string& path);
+    std::shared_ptr<FileRequest> write(const std::string& path, std::string&& data);
+
+    static AsyncIO& get();
+
+    // the SDL event type announcing finished requests; must first be
+    // called from the main thread
+    static uint32_t getEventType();
+};
@@ -0,0 +1,80 @@
+#include "LuaAllocator.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <lua.hpp>
+
+LuaAllocStats LuaAllocator::stats = {};
+std::unique_ptr<LuaPool> LuaAllocator::pool;
+
+
+void* LuaAllocator::alloc(void* ud, void* ptr, size_t osize, size_t nsize)
+{
+    auto blocks = reinterpret_cast<LuaPool*>(ud);
+
+    // `osize` is the block's size only when `ptr` is set
+    if (!ptr) osize = 0;
+
+    if (nsize == 0)
+    {
+        if (ptr)
+        {
+            if (blocks) blocks->reallocate(ptr, osize, 0);
+            else free(ptr);
+            stats.bytes -= osize;
+            stats.frees++;
+        }
+        return nullptr;
+    }
+
+    auto block = blocks ? blocks->reallocate(ptr, osize, nsize) : realloc(ptr, nsize);
+    if (!block) return nullptr;
+
+    stats.bytes += nsize - osize;
+    if (stats.bytes > stats.peakBytes) stats.peakBytes = stats.bytes;
+    if (!ptr) stats.allocations++;
+    if (nsize > osize)
+    {
+        stats.currentFrameAllocations++;
+        stats.currentFrameBytes += nsize - osize;
+    }
+    return block;
+}
+
+LuaAllocator::Mode LuaAllocator::parseMode(const char* name)
+{
+    return name && strcmp(name, "pool") == 0 ? POOL : MALLOC;
+}
+
+lua_State* LuaAllocator::newState(Mode mode, bool hugePages)
+{
+    if (mode == POOL && !pool) pool = std::make_unique<LuaPool>(hugePages);
+
+    auto L = lua_newstate(alloc, mode == POOL ? pool.get() : nullptr);
+    return L ? L : luaL_newstate();
+}
+
+bool LuaAllocator::isUsedBy(lua_State* L)
+{
+    return lua_getallocf(L, nullptr) == alloc;
+}
+
+const LuaPool* LuaAllocator::getPool(lua_State* L)
+{
+    void* ud = nullptr;
+    if (lua_getallocf(L, &ud) != alloc) return nullptr;
+    return reinterpret_cast<LuaPool*>(ud);
+}
+
+const LuaAllocStats& LuaAllocator::getStats()
+{
+    return stats;
+}
+
+void LuaAllocator::endFrame()
+{
+    stats.frameAllocations = stats.currentFrameAllocations;
+    stats.frameBytes = stats.currentFrameBytes;
+    stats.currentFrameAllocations = 0;
+    stats.currentFrameBytes = 0;
+}
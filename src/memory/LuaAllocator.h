@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+
+#include "LuaPool.h"
+
+struct lua_State;
+
+struct LuaAllocStats
+{
+    // bytes the Lua state holds now, and at most so far
+    size_t bytes;
+    size_t peakBytes;
+
+    uint64_t allocations;
+    uint64_t frees;
+
+    // allocations and bytes allocated during the last frame, and so far
+    // during the current one; growing a block counts as an allocation
+    uint64_t frameAllocations;
+    uint64_t frameBytes;
+    uint64_t currentFrameAllocations;
+    uint64_t currentFrameBytes;
+};
+
+// Allocator of the editor's Lua state, counting what Lua allocates. Blocks
+// come from malloc, or from a LuaPool when the pool is chosen at startup.
+// Only the main thread's state uses it, so the counters are not atomic.
+class LuaAllocator
+{
+public:
+    enum Mode
+    {
+        MALLOC,
+        POOL
+    };
+
+private:
+    static LuaAllocStats stats;
+    static std::unique_ptr<LuaPool> pool;
+
+    static void* alloc(void* ud, void* ptr, size_t osize, size_t nsize);
+
+public:
+    // "pool" or "malloc"; anything else is malloc
+    static Mode parseMode(const char* name);
+
+    // creates a state using this allocator; falls back to luaL_newstate
+    // where LuaJIT does not accept a custom allocator (x64 without GC64)
+    static lua_State* newState(Mode mode, bool hugePages);
+
+    // whether `L` allocates through this allocator, so the stats cover it
+    static bool isUsedBy(lua_State* L);
+
+    // the pool of `L`, or null if it allocates through malloc
+    static const LuaPool* getPool(lua_State* L);
+
+    static const LuaAllocStats& getStats();
+
+    // starts counting a new frame's allocations
+    static void endFrame();
+};
@@ -0,0 +1,134 @@
+#include "LuaPool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+
+LuaPool::LuaPool(bool hugePages) : arenaNext(nullptr), arenaEnd(nullptr), hugePages(hugePages), stats{}
+{
+    memset(freeLists, 0, sizeof(freeLists));
+}
+
+LuaPool::~LuaPool()
+{
+    for (auto arena : arenas)
+    {
+#ifdef _WIN32
+        _aligned_free(arena);
+#else
+        free(arena);
+#endif
+    }
+}
+
+const LuaPoolStats& LuaPool::getStats() const
+{
+    return stats;
+}
+
+size_t LuaPool::classOf(size_t size)
+{
+    return (size + POOL_GRANULE - 1) / POOL_GRANULE - 1;
+}
+
+bool LuaPool::newArena()
+{
+    void* arena = nullptr;
+#ifdef _WIN32
+    arena = _aligned_malloc(POOL_ARENA_SIZE, POOL_ARENA_SIZE);
+#else
+    if (posix_memalign(&arena, POOL_ARENA_SIZE, POOL_ARENA_SIZE) != 0) arena = nullptr;
+#endif
+    if (!arena) return false;
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (hugePages) madvise(arena, POOL_ARENA_SIZE, MADV_HUGEPAGE);
+#endif
+
+    arenas.push_back(arena);
+    arenaNext = reinterpret_cast<char*>(arena);
+    arenaEnd = arenaNext + POOL_ARENA_SIZE;
+    stats.arenas++;
+    stats.arenaBytes += POOL_ARENA_SIZE;
+    return true;
+}
+
+void* LuaPool::allocate(size_t size)
+{
+    if (size > POOL_MAX_SIZE)
+    {
+        stats.large++;
+        return malloc(size);
+    }
+
+    auto cls = classOf(size);
+    auto blockSize = (cls + 1) * POOL_GRANULE;
+    void* block = freeLists[cls];
+    if (block)
+    {
+        freeLists[cls] = freeLists[cls]->next;
+        stats.freeBytes -= blockSize;
+    }
+    else
+    {
+        // the rest of a full arena is too small for this class and is left
+        if (arenaEnd - arenaNext < static_cast<ptrdiff_t>(blockSize) && !newArena()) return nullptr;
+        block = arenaNext;
+        arenaNext += blockSize;
+    }
+
+    stats.pooled++;
+    stats.blockBytes += blockSize;
+    stats.requestedBytes += size;
+    return block;
+}
+
+void LuaPool::release(void* ptr, size_t size)
+{
+    if (size > POOL_MAX_SIZE)
+    {
+        free(ptr);
+        return;
+    }
+
+    auto cls = classOf(size);
+    auto blockSize = (cls + 1) * POOL_GRANULE;
+    auto block = reinterpret_cast<FreeBlock*>(ptr);
+    block->next = freeLists[cls];
+    freeLists[cls] = block;
+    stats.freeBytes += blockSize;
+    stats.blockBytes -= blockSize;
+    stats.requestedBytes -= size;
+}
+
+void* LuaPool::reallocate(void* ptr, size_t osize, size_t nsize)
+{
+    if (nsize == 0)
+    {
+        if (ptr) release(ptr, osize);
+        return nullptr;
+    }
+
+    if (ptr)
+    {
+        if (osize > POOL_MAX_SIZE && nsize > POOL_MAX_SIZE) return realloc(ptr, nsize);
+        if (osize <= POOL_MAX_SIZE && nsize <= POOL_MAX_SIZE && classOf(osize) == classOf(nsize))
+        {
+            stats.requestedBytes += nsize - osize;
+            return ptr;
+        }
+    }
+
+    auto block = allocate(nsize);
+    if (!block) return nullptr;
+    if (ptr)
+    {
+        memcpy(block, ptr, osize < nsize ? osize : nsize);
+        release(ptr, osize);
+    }
+    return block;
+}
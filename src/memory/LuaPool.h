@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// blocks up to POOL_MAX_SIZE bytes come from free lists, one per multiple
+// of POOL_GRANULE; bigger ones from malloc
+#define POOL_GRANULE 16
+#define POOL_MAX_SIZE 256
+#define POOL_CLASSES (POOL_MAX_SIZE / POOL_GRANULE)
+
+// the size of a huge page on x86-64, so an arena can be backed by one
+#define POOL_ARENA_SIZE (2 * 1024 * 1024)
+
+struct LuaPoolStats
+{
+    size_t arenas;
+    size_t arenaBytes;
+
+    // bytes of the live pooled blocks, and the part of them Lua asked for
+    size_t blockBytes;
+    size_t requestedBytes;
+
+    // bytes on the free lists
+    size_t freeBytes;
+
+    // allocations served by the pool and by malloc
+    uint64_t pooled;
+    uint64_t large;
+};
+
+// Size-class pool for the many small, short-lived objects of a Lua state.
+// Lua passes the old size to its allocator, so blocks carry no header and
+// a freed block goes straight back to its class's free list. Arenas are
+// kept until the pool is destroyed. Not thread safe: each state is only
+// used by one thread, so each gets its own pool.
+class LuaPool
+{
+private:
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    FreeBlock* freeLists[POOL_CLASSES];
+    std::vector<void*> arenas;
+    char* arenaNext;
+    char* arenaEnd;
+    bool hugePages;
+    LuaPoolStats stats;
+
+    static size_t classOf(size_t size);
+
+    void* allocate(size_t size);
+    void release(void* ptr, size_t size);
+    bool newArena();
+
+public:
+    // `hugePages` asks the system to back arenas with huge pages where it
+    // can (Linux transparent huge pages)
+    LuaPool(bool hugePages);
+    ~LuaPool();
+
+    // lua_Alloc semantics, with `osize` 0 when `ptr` is null
+    void* reallocate(void* ptr, size_t osize, size_t nsize);
+
+    const LuaPoolStats& getStats() const;
+};
@@ -0,0 +1,429 @@
+#include "Process.h"
+
+#include <SDL.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+// output read in one go; chunks the main thread has not taken yet are
+// merged up to PROCESS_MERGE_SIZE so a chatty process costs few events
+#define PROCESS_READ_SIZE 65536
+#define PROCESS_MERGE_SIZE (1024 * 1024)
+
+// how often the child is checked for where it can not be polled
+#define PROCESS_EXIT_CHECK_MS 100
+
+std::unordered_map<uint32_t, Process*> Process::processes;
+uint32_t Process::nextId = 1;
+uint32_t Process::eventType = 0;
+
+
+Process::Process()
+    : id(nextId++), pid(-1), stdinFd(-1), stdoutFd(-1), stderrFd(-1), closeInput(false), exited(false), notified(false), stopping(false), running(false)
+{
+    wakeFds[0] = wakeFds[1] = -1;
+    getEventType();
+    processes[id] = this;
+}
+
+uint32_t Process::getId() const
+{
+    return id;
+}
+
+bool Process::isRunning() const
+{
+    return running;
+}
+
+bool Process::receive(ProcessEvent& event)
+{
+    bool more;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        notified = false;
+        if (events.empty()) return false;
+        event = std::move(events.front());
+        events.pop_front();
+        more = !events.empty();
+    }
+
+    // each SDL event delivers one process event and announces the next
+    if (more) notify();
+    return true;
+}
+
+Process* Process::find(uint32_t id)
+{
+    auto it = processes.find(id);
+    return it == processes.end() ? nullptr : it->second;
+}
+
+uint32_t Process::getEventType()
+{
+    if (eventType == 0) eventType = SDL_RegisterEvents(1);
+    return eventType;
+}
+
+bool Process::post(ProcessEvent::Type type, const char* data, size_t size, int status)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto merged = false;
+        if (type != ProcessEvent::EXIT && !events.empty())
+        {
+            auto& last = events.back();
+            if (last.type == type && last.data.size() + size <= PROCESS_MERGE_SIZE)
+            {
+                last.data.append(data, size);
+                merged = true;
+            }
+        }
+
+        if (!merged)
+        {
+            ProcessEvent event;
+            event.type = type;
+            event.data.assign(data, size);
+            event.status = status;
+            events.push_back(std::move(event));
+        }
+    }
+    return notify();
+}
+
+// returns false if SDL's queue is full; the events stay queued for the
+// next attempt
+bool Process::notify()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (notified) return true;
+        notified = true;
+    }
+
+    SDL_Event e;
+    SDL_zero(e);
+    e.type = eventType;
+    e.user.code = static_cast<Sint32>(id);
+    if (SDL_PushEvent(&e) > 0) return true;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    notified = false;
+    return false;
+}
+
+
+#ifdef _WIN32
+
+Process::~Process()
+{
+    processes.erase(id);
+}
+
+bool Process::start(const std::vector<std::string>& args, std::string& error)
+{
+    error = "starting processes is not supported on this platform";
+    return false;
+}
+
+void Process::write(const char* data, size_t size) {}
+void Process::closeStdin() {}
+void Process::wakeThread() {}
+void Process::run() {}
+
+bool Process::kill(bool force)
+{
+    return false;
+}
+
+#else
+
+static bool make_pipe(int fds[2], bool nonBlockingRead, bool nonBlockingWrite)
+{
+    if (pipe(fds) != 0) return false;
+    for (int i = 0; i < 2; i++)
+    {
+        fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+        if (i == 0 ? nonBlockingRead : nonBlockingWrite)
+            fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+    }
+    return true;
+}
+
+static void close_fd(int& fd)
+{
+    if (fd >= 0) close(fd);
+    fd = -1;
+}
+
+// a descriptor which becomes readable when the child exits, or -1 where
+// the kernel has no pidfd_open
+static int open_pidfd(pid_t pid)
+{
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    return -1;
+#endif
+}
+
+Process::~Process()
+{
+    if (thread.joinable())
+    {
+        // the child's own children may keep the pipes open, so the thread
+        // is told to stop instead of waiting for end of file
+        kill(true);
+        stopping = true;
+        wakeThread();
+        thread.join();
+    }
+    close_fd(wakeFds[0]);
+    close_fd(wakeFds[1]);
+    processes.erase(id);
+}
+
+bool Process::start(const std::vector<std::string>& args, std::string& error)
+{
+    if (args.empty())
+    {
+        error = "no program given";
+        return false;
+    }
+
+    // writes to a child which closed its stdin fail with EPIPE instead
+    static bool ignoredSigpipe = false;
+    if (!ignoredSigpipe)
+    {
+        signal(SIGPIPE, SIG_IGN);
+        ignoredSigpipe = true;
+    }
+
+    int in[2] = { -1, -1 }, out[2] = { -1, -1 }, err[2] = { -1, -1 };
+    if (!make_pipe(in, false, true) || !make_pipe(out, true, false) || !make_pipe(err, true, false) || !make_pipe(wakeFds, true, true))
+    {
+        error = strerror(errno);
+        for (auto fd : { in[0], in[1], out[0], out[1], err[0], err[1] }) if (fd >= 0) close(fd);
+        close_fd(wakeFds[0]);
+        close_fd(wakeFds[1]);
+        return false;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, in[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, out[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, err[1], STDERR_FILENO);
+
+    // the child gets its own process group so `kill` reaches everything it
+    // starts, and the default SIGPIPE the editor itself ignores
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t defaults;
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    posix_spawnattr_setpgroup(&attr, 0);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETPGROUP);
+
+    std::vector<char*> argv;
+    for (auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    pid_t child;
+    int res = posix_spawnp(&child, argv[0], &actions, &attr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+
+    close(in[0]);
+    close(out[1]);
+    close(err[1]);
+    if (res != 0)
+    {
+        error = strerror(res);
+        close(in[1]);
+        close(out[0]);
+        close(err[0]);
+        close_fd(wakeFds[0]);
+        close_fd(wakeFds[1]);
+        return false;
+    }
+
+    pid = child;
+    stdinFd = in[1];
+    stdoutFd = out[0];
+    stderrFd = err[0];
+    running = true;
+    thread = std::thread(&Process::run, this);
+    return true;
+}
+
+void Process::wakeThread()
+{
+    if (wakeFds[1] < 0) return;
+    char c = 0;
+    ssize_t res = ::write(wakeFds[1], &c, 1);
+    (void)res;
+}
+
+void Process::write(const char* data, size_t size)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closeInput) return;
+        input.append(data, size);
+    }
+    wakeThread();
+}
+
+void Process::closeStdin()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closeInput = true;
+    }
+    wakeThread();
+}
+
+bool Process::kill(bool force)
+{
+    // `exited` is set before the child is reaped, so its pid can not have
+    // been reused while it is false
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pid < 0 || exited) return false;
+    return ::kill(-pid, force ? SIGKILL : SIGTERM) == 0;
+}
+
+void Process::run()
+{
+    std::vector<char> buffer(PROCESS_READ_SIZE);
+    std::string pending;
+
+    auto readStream = [&](int& fd, ProcessEvent::Type type)
+    {
+        ssize_t n = read(fd, buffer.data(), buffer.size());
+        if (n > 0)
+            post(type, buffer.data(), static_cast<size_t>(n), 0);
+        else if (n == 0 || (errno != EINTR && errno != EAGAIN))
+            close_fd(fd);
+    };
+
+    // takes whatever is already written without waiting for more
+    auto drainStream = [&](int& fd, ProcessEvent::Type type)
+    {
+        while (fd >= 0)
+        {
+            ssize_t n = read(fd, buffer.data(), buffer.size());
+            if (n > 0)
+                post(type, buffer.data(), static_cast<size_t>(n), 0);
+            else if (n < 0 && errno == EINTR)
+                continue;
+            else
+                break;
+        }
+    };
+
+    auto childExited = [&]
+    {
+        siginfo_t info;
+        info.si_pid = 0;
+        return waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid != 0;
+    };
+
+    int pidFd = open_pidfd(pid);
+    while ((stdoutFd >= 0 || stderrFd >= 0) && !stopping)
+    {
+        bool closing;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.append(input);
+            input.clear();
+            closing = closeInput;
+        }
+        if (closing && pending.empty()) close_fd(stdinFd);
+
+        pollfd fds[5];
+        nfds_t count = 0;
+        int outIndex = -1, errIndex = -1, inIndex = -1, pidIndex = -1;
+        fds[count++] = { wakeFds[0], POLLIN, 0 };
+        if (stdoutFd >= 0) { outIndex = count; fds[count++] = { stdoutFd, POLLIN, 0 }; }
+        if (stderrFd >= 0) { errIndex = count; fds[count++] = { stderrFd, POLLIN, 0 }; }
+        if (stdinFd >= 0 && !pending.empty()) { inIndex = count; fds[count++] = { stdinFd, POLLOUT, 0 }; }
+        if (pidFd >= 0) { pidIndex = count; fds[count++] = { pidFd, POLLIN, 0 }; }
+
+        if (poll(fds, count, pidFd >= 0 ? -1 : PROCESS_EXIT_CHECK_MS) < 0)
+        {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        if (fds[0].revents)
+        {
+            char drain[64];
+            while (read(wakeFds[0], drain, sizeof(drain)) > 0) {}
+        }
+        if (outIndex >= 0 && fds[outIndex].revents) readStream(stdoutFd, ProcessEvent::STDOUT);
+        if (errIndex >= 0 && fds[errIndex].revents) readStream(stderrFd, ProcessEvent::STDERR);
+        if (inIndex >= 0 && fds[inIndex].revents)
+        {
+            ssize_t n = (fds[inIndex].revents & POLLOUT) ? ::write(stdinFd, pending.data(), pending.size()) : -1;
+            if (n > 0)
+            {
+                pending.erase(0, static_cast<size_t>(n));
+            }
+            else if (n < 0 && errno != EINTR && errno != EAGAIN)
+            {
+                // the child stopped reading; the rest of its input is dropped
+                close_fd(stdinFd);
+                pending.clear();
+            }
+        }
+
+        // something the child started in the background may keep the
+        // pipes open long after the child itself is gone
+        if (pidIndex >= 0 ? fds[pidIndex].revents != 0 : childExited())
+        {
+            drainStream(stdoutFd, ProcessEvent::STDOUT);
+            drainStream(stderrFd, ProcessEvent::STDERR);
+            break;
+        }
+    }
+    close_fd(pidFd);
+    close_fd(stdinFd);
+    close_fd(stdoutFd);
+    close_fd(stderrFd);
+
+    // wait without reaping first, so `kill` never signals a reused pid
+    siginfo_t info;
+    while (waitid(P_PID, pid, &info, WEXITED | WNOWAIT) != 0 && errno == EINTR) {}
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        exited = true;
+    }
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+
+    int code = WIFEXITED(status) ? WEXITSTATUS(status) : WIFSIGNALED(status) ? -WTERMSIG(status) : -1;
+    running = false;
+
+    // nothing else will announce the exit, so keep trying until the main
+    // thread has room for it or the process object goes away
+    if (!post(ProcessEvent::EXIT, "", 0, code))
+    {
+        while (!notify() && !stopping) SDL_Delay(10);
+    }
+}
+
+#endif
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct ProcessEvent
+{
+    enum Type
+    {
+        STDOUT,
+        STDERR,
+        EXIT
+    };
+
+    Type type;
+    std::string data;
+
+    // exit code, or the negated signal number if a signal ended the process
+    int status = 0;
+};
+
+// Runs a program with its standard streams connected to pipes; no shell is
+// involved. A thread per process streams stdout and stderr chunks and the
+// exit status back as events, announced with an SDL event so they arrive
+// through the normal event loop, and feeds queued stdin writes to the
+// child without blocking the main thread. The exit is reported when the
+// child dies, even if something it started still holds the pipes open.
+class Process
+{
+private:
+    static std::unordered_map<uint32_t, Process*> processes;
+    static uint32_t nextId;
+    static uint32_t eventType;
+
+    uint32_t id;
+    int pid;
+    int stdinFd;
+    int stdoutFd;
+    int stderrFd;
+
+    // written to by the main thread to interrupt the thread's poll
+    int wakeFds[2];
+
+    std::mutex mutex;
+    std::string input;
+    bool closeInput;
+    bool exited;
+    std::deque<ProcessEvent> events;
+
+    // set while an SDL event announcing `events` is queued
+    bool notified;
+    std::atomic<bool> stopping;
+    std::atomic<bool> running;
+    std::thread thread;
+
+    void run();
+    bool post(ProcessEvent::Type type, const char* data, size_t size, int status);
+    bool notify();
+    void wakeThread();
+
+public:
+    Process();
+    ~Process();
+
+    Process(const Process&) = delete;
+    Process& operator=(const Process&) = delete;
+
+    // `args[0]` is looked up in PATH; returns false with `error` set if the
+    // program could not be started
+    bool start(const std::vector<std::string>& args, std::string& error);
+
+    uint32_t getId() const;
+    bool isRunning() const;
+
+    // queues data for the child's stdin
+    void write(const char* data, size_t size);
+
+    // closes stdin once the queued data is written
+    void closeStdin();
+
+    // sends SIGTERM, or SIGKILL if `force`; returns false once exited
+    bool kill(bool force);
+
+    // main thread side
+    bool receive(ProcessEvent& event);
+
+    static Process* find(uint32_t id);
+
+    // the SDL event type announcing process events; must first be called
+    // from the main thread
+    static uint32_t getEventType();
+};
@@ -0,0 +1,173 @@
+#include "Profiler.h"
+
+#include <lua.hpp>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+std::atomic<const char*> Profiler::zones[PROFILER_MAX_ZONES];
+std::atomic<int> Profiler::zoneDepth(0);
+lua_State* Profiler::mainState = nullptr;
+std::atomic<bool> Profiler::running(false);
+std::atomic<bool> Profiler::sampleDue(false);
+std::mutex Profiler::mutex;
+std::map<std::string, uint64_t> Profiler::pending;
+std::map<std::string, uint64_t> Profiler::samples;
+uint64_t Profiler::sampleCount = 0;
+std::thread Profiler::thread;
+const char* const Profiler::IDLE = "[idle]";
+
+
+#pragma region ZONES
+void Profiler::enterZone(const char* name)
+{
+    int depth = zoneDepth.load(std::memory_order_relaxed);
+    if (depth < PROFILER_MAX_ZONES) zones[depth].store(name, std::memory_order_relaxed);
+    zoneDepth.store(depth + 1, std::memory_order_release);
+}
+
+void Profiler::leaveZone()
+{
+    zoneDepth.store(zoneDepth.load(std::memory_order_relaxed) - 1, std::memory_order_release);
+}
+#pragma endregion
+
+
+#pragma region SAMPLING
+bool Profiler::start(lua_State* L, double interval)
+{
+    if (running) return false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.clear();
+        samples.clear();
+        sampleCount = 0;
+    }
+    // os.exit skips App's destructor, and a joinable std::thread left
+    // for static destruction terminates the program
+    static bool registered = false;
+    if (!registered)
+    {
+        atexit(stop);
+        registered = true;
+    }
+
+    mainState = L;
+    sampleDue = false;
+    running = true;
+    lua_sethook(L, hook, LUA_MASKCOUNT, PROFILER_HOOK_COUNT);
+    thread = std::thread(run, interval);
+    return true;
+}
+
+void Profiler::stop()
+{
+    if (!running) return;
+
+    running = false;
+    thread.join();
+    lua_sethook(mainState, nullptr, 0, 0);
+
+    // samples taken in native code after the last hook still count
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& [zoneStack, count] : pending)
+    {
+        samples[zoneStack.empty() ? "[unknown]" : zoneStack.substr(1)] += count;
+        sampleCount += count;
+    }
+    pending.clear();
+}
+
+bool Profiler::isRunning()
+{
+    return running;
+}
+
+void Profiler::run(double interval)
+{
+    auto period = std::chrono::duration<double>(interval);
+    auto next = std::chrono::steady_clock::now();
+    while (running)
+    {
+        next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+        std::this_thread::sleep_until(next);
+
+        int depth = zoneDepth.load(std::memory_order_acquire);
+        if (depth > PROFILER_MAX_ZONES) depth = PROFILER_MAX_ZONES;
+
+        std::string zoneStack;
+        bool idle = false;
+        for (int i = 0; i < depth; i++)
+        {
+            auto name = zones[i].load(std::memory_order_relaxed);
+            if (name == IDLE) idle = true;
+            zoneStack += ';';
+            zoneStack += name;
+        }
+        if (idle) continue;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        pending[zoneStack]++;
+        sampleDue = true;
+    }
+}
+
+void Profiler::appendStack(lua_State* L, std::string& stack)
+{
+    std::vector<lua_Debug> frames;
+    lua_Debug ar;
+    for (int level = 0; lua_getstack(L, level, &ar); level++)
+    {
+        lua_getinfo(L, "nS", &ar);
+        frames.push_back(ar);
+    }
+
+    char buf[256];
+    for (auto it = frames.rbegin(); it != frames.rend(); ++it)
+    {
+        auto name = it->name ? it->name : "?";
+        if (*it->what == 'C')
+            snprintf(buf, sizeof(buf), "[C] %s", name);
+        else if (*it->what == 'm')
+            snprintf(buf, sizeof(buf), "%s", it->short_src);
+        else
+            snprintf(buf, sizeof(buf), "%s %s:%d", name, it->short_src, it->linedefined);
+
+        if (!stack.empty()) stack += ';';
+        for (auto c = buf; *c; c++) stack += *c == ';' ? ':' : *c;
+    }
+}
+
+void Profiler::hook(lua_State* L, lua_Debug* ar)
+{
+    if (!sampleDue.exchange(false)) return;
+
+    std::string stack;
+    if (L != mainState) appendStack(mainState, stack);
+    appendStack(L, stack);
+    if (stack.empty()) stack = "[unknown]";
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& [zoneStack, count] : pending)
+    {
+        samples[stack + zoneStack] += count;
+        sampleCount += count;
+    }
+    pending.clear();
+}
+
+bool Profiler::write(const char* path, uint64_t& count)
+{
+    FILE* fp = fopen(path, "wb");
+    if (!fp) return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& [stack, n] : samples)
+        fprintf(fp, "%s %llu\n", stack.c_str(), (unsigned long long)n);
+    count = sampleCount;
+    return fclose(fp) == 0;
+}
+#pragma endregion
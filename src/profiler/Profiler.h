@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct lua_State;
+struct lua_Debug;
+
+#define PROFILER_MAX_ZONES 16
+
+// lua instructions between checks for a due sample
+#define PROFILER_HOOK_COUNT 100
+
+// Samples where the main thread spends its time. A sampler thread wakes
+// every interval, notes the native zones the main thread is in and flags
+// a sample; a count hook on the Lua state then adds the Lua stack, that
+// of the main state followed by the coroutine's when a core thread runs.
+// Samples are kept as folded stacks, one line per distinct stack, which
+// flame graph tools read directly. Time spent waiting for events is not
+// sampled.
+class Profiler
+{
+private:
+    static std::atomic<const char*> zones[PROFILER_MAX_ZONES];
+    static std::atomic<int> zoneDepth;
+
+    static lua_State* mainState;
+    static std::atomic<bool> running;
+    static std::atomic<bool> sampleDue;
+    static std::mutex mutex;
+    static std::map<std::string, uint64_t> pending;
+    static std::map<std::string, uint64_t> samples;
+    static uint64_t sampleCount;
+    static std::thread thread;
+
+    static void run(double interval);
+    static void hook(lua_State* L, lua_Debug* ar);
+    static void appendStack(lua_State* L, std::string& stack);
+
+public:
+    // `L` must be the main state; `interval` is in seconds
+    static bool start(lua_State* L, double interval);
+
+    // must run before the main state is closed; also runs at exit
+    static void stop();
+    static bool isRunning();
+
+    // writes the folded stacks collected since the last start
+    static bool write(const char* path, uint64_t& count);
+
+    static void enterZone(const char* name);
+    static void leaveZone();
+
+    // a zone whose samples are dropped, around waits for events
+    static const char* const IDLE;
+};
+
+// marks a native function in profiles for as long as it is in scope
+class ProfileZone
+{
+public:
+    ProfileZone(const char* name) { Profiler::enterZone(name); }
+    ~ProfileZone() { Profiler::leaveZone(); }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+};
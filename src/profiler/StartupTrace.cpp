@@ -0,0 +1,91 @@
+#include "StartupTrace.h"
+
+#include <stdio.h>
+#include <algorithm>
+
+bool StartupTrace::enabled = false;
+std::string StartupTrace::filename;
+std::chrono::steady_clock::time_point StartupTrace::origin;
+std::vector<StartupTrace::Span> StartupTrace::spans;
+std::vector<size_t> StartupTrace::open;
+
+
+double StartupTrace::now()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void StartupTrace::init(const char* path)
+{
+    if (!path || !*path) return;
+    enabled = true;
+    filename = path;
+    origin = std::chrono::steady_clock::now();
+}
+
+bool StartupTrace::isEnabled()
+{
+    return enabled;
+}
+
+void StartupTrace::begin(const std::string& name)
+{
+    if (!enabled) return;
+    open.push_back(spans.size());
+    spans.push_back(Span{ name, now(), 0, 0, static_cast<int>(open.size()) - 1 });
+}
+
+void StartupTrace::end()
+{
+    if (!enabled || open.empty()) return;
+    auto& span = spans[open.back()];
+    open.pop_back();
+    span.end = now();
+    if (!open.empty()) spans[open.back()].children += span.end - span.start;
+}
+
+bool StartupTrace::finish(const char* name)
+{
+    if (!enabled) return false;
+
+    // spans still open, such as the one around the Lua startup script,
+    // end here
+    while (!open.empty()) end();
+    auto time = now();
+    spans.push_back(Span{ name, time, time, 0, 0 });
+
+    auto written = write();
+    enabled = false;
+    spans.clear();
+    return written;
+}
+
+bool StartupTrace::write()
+{
+    auto fp = fopen(filename.c_str(), "wb");
+    if (!fp) return false;
+
+    fprintf(fp, "# startup trace, in ms since startup\n");
+    fprintf(fp, "# %10s %10s %10s  name\n", "start", "total", "self");
+    for (auto& span : spans)
+    {
+        auto total = span.end - span.start;
+        fprintf(fp, "  %10.3f %10.3f %10.3f  %*s%s\n", span.start * 1000, total * 1000,
+            (total - span.children) * 1000, span.depth * 2, "", span.name.c_str());
+    }
+
+    std::vector<const Span*> slowest;
+    for (auto& span : spans) slowest.push_back(&span);
+    auto self = [](const Span* span) { return span->end - span->start - span->children; };
+    std::sort(slowest.begin(), slowest.end(), [&](const Span* a, const Span* b) { return self(a) > self(b); });
+    if (slowest.size() > STARTUP_TRACE_SLOWEST) slowest.resize(STARTUP_TRACE_SLOWEST);
+
+    fprintf(fp, "\n# slowest by self time\n");
+    for (auto span : slowest)
+    {
+        fprintf(fp, "  %10.3f  %s\n", self(span) * 1000, span->name.c_str());
+    }
+
+    fclose(fp);
+    return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// spans of the startup trace listed as the slowest by their own time
+#define STARTUP_TRACE_SLOWEST 20
+
+// Times the steps of startup when LITE_STARTUP_TRACE names a report file.
+// Spans nest: native steps, each `require`, plugin and font load. The
+// first frame to reach end_frame ends the trace and writes the report,
+// which lists every span with its start, its total and its own time, then
+// the slowest spans by own time.
+class StartupTrace
+{
+private:
+    struct Span
+    {
+        std::string name;
+        double start;
+        double end;
+        double children;
+        int depth;
+    };
+
+    static bool enabled;
+    static std::string filename;
+    static std::chrono::steady_clock::time_point origin;
+    static std::vector<Span> spans;
+    static std::vector<size_t> open;
+
+    static double now();
+    static bool write();
+
+public:
+    // starts tracing if `path` is set
+    static void init(const char* path);
+    static bool isEnabled();
+
+    static void begin(const std::string& name);
+    static void end();
+
+    // records `name` as the last step, writes the report and stops tracing
+    static bool finish(const char* name);
+};
+
+// a span of the startup trace for as long as it is in scope
+class StartupSpan
+{
+public:
+    StartupSpan(const char* name) { if (StartupTrace::isEnabled()) StartupTrace::begin(name); }
+    ~StartupSpan() { if (StartupTrace::isEnabled()) StartupTrace::end(); }
+
+    StartupSpan(const StartupSpan&) = delete;
+    StartupSpan& operator=(const StartupSpan&) = delete;
+};
@@ -0,0 +1,152 @@
+#include "DirLister.h"
+#include "../scheduler/Wakeup.h"
+
+#include <vector>
+
+#ifdef _WIN32
+#define PATHSEP '\\'
+#else
+#define PATHSEP '/'
+#endif
+
+
+DirLister::DirLister(const std::string& root, uint64_t sizeLimit, bool useIgnoreFiles)
+    : root(root), sizeLimit(sizeLimit), useIgnoreFiles(useIgnoreFiles), excludeStamp(0), hasExclude(false), stopping(false)
+{
+    Wakeup::getEventType();
+    thread = std::thread(&DirLister::run, this);
+}
+
+DirLister::~DirLister()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_one();
+    thread.join();
+}
+
+const std::string& DirLister::getRoot() const
+{
+    return root;
+}
+
+void DirLister::request(const std::string& relPath)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.push_back(relPath);
+    }
+    condition.notify_one();
+}
+
+bool DirLister::poll(std::string& relPath, DirListing& listing)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (results.empty()) return false;
+
+    relPath = std::move(results.front().first);
+    listing = std::move(results.front().second);
+    results.pop_front();
+    return true;
+}
+
+void DirLister::run()
+{
+    while (true)
+    {
+        std::string relPath;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return stopping || !requests.empty(); });
+            if (stopping) return;
+            relPath = std::move(requests.front());
+            requests.pop_front();
+        }
+
+        DirListing listing;
+        if (!list(relPath, listing)) continue;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            results.emplace_back(std::move(relPath), std::move(listing));
+        }
+        Wakeup::post();
+    }
+}
+
+std::string DirLister::getPath(const std::string& relPath) const
+{
+    auto path = root;
+    if (relPath.empty()) return path;
+
+    path.push_back(PATHSEP);
+    for (auto c : relPath) path.push_back(c == '/' ? PATHSEP : c);
+    path.pop_back();
+    return path;
+}
+
+const IgnoreFrame* DirLister::getFrame(const std::string& relPath, uint64_t& rulesStamp)
+{
+    auto path = getPath(relPath);
+    auto stamp = DirReader::stampIgnoreFiles(path, false, 0);
+    auto& cached = frames[relPath];
+    if (!cached.stamp || cached.stamp != stamp)
+    {
+        cached.stamp = stamp;
+        cached.frame = std::make_unique<IgnoreFrame>();
+        if (!DirReader::loadIgnoreFrame(path, relPath, *cached.frame)) cached.frame.reset();
+    }
+    rulesStamp = (rulesStamp ^ stamp) * 1099511628211ull;
+    return cached.frame.get();
+}
+
+bool DirLister::list(const std::string& relPath, DirListing& listing)
+{
+    std::vector<const IgnoreFrame*> stack;
+    uint64_t rulesStamp = 0;
+    if (useIgnoreFiles)
+    {
+        auto stamp = DirReader::stampIgnoreFiles(root, true, 0);
+        if (stamp != excludeStamp)
+        {
+            excludeStamp = stamp;
+            exclude = IgnoreFrame();
+            hasExclude = DirReader::loadExcludeFrame(root, exclude);
+        }
+        if (hasExclude) stack.push_back(&exclude);
+        rulesStamp = excludeStamp;
+
+        // every ancestor's ignore file applies, from the root down
+        for (size_t pos = 0; pos != std::string::npos; pos = relPath.find('/', pos))
+        {
+            if (pos > 0) pos++;
+            auto frame = getFrame(relPath.substr(0, pos), rulesStamp);
+            if (frame) stack.push_back(frame);
+            if (pos >= relPath.size()) break;
+        }
+    }
+
+    // the view is refreshed by relisting its open directories, most of
+    // which have not changed since they were last listed
+    auto path = getPath(relPath);
+    auto modified = DirReader::getModifiedTime(path);
+    auto last = delivered.find(relPath);
+    if (last != delivered.end() && modified != -1 &&
+        last->second.modified == modified && last->second.rulesStamp == rulesStamp)
+    {
+        bool changed = false;
+        if (DirReader::refreshFiles(path, last->second, sizeLimit, changed))
+        {
+            if (!changed) return false;
+            listing = last->second;
+            return true;
+        }
+    }
+
+    listing = DirReader::read(path, relPath, stack, sizeLimit);
+    listing.rulesStamp = rulesStamp;
+    delivered[relPath] = listing;
+    return true;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "DirReader.h"
+
+// Lists single project directories on request on a background thread, for
+// views which only need the directories the user opened. Ignore files are
+// loaded from the root down to each requested directory and kept until
+// their mtime or size changes. A directory is only listed again once its
+// mtime or its ignore rules change; until then its files are restated and
+// the listing is only handed out again if one of them changed.
+class DirLister
+{
+private:
+    std::string root;
+    uint64_t sizeLimit;
+    bool useIgnoreFiles;
+
+    // a frame is null for a directory without ignore files
+    struct CachedFrame
+    {
+        uint64_t stamp;
+        std::unique_ptr<IgnoreFrame> frame;
+    };
+
+    std::unordered_map<std::string, CachedFrame> frames;
+    IgnoreFrame exclude;
+    uint64_t excludeStamp;
+    bool hasExclude;
+
+    // the last listing handed out for each path
+    std::unordered_map<std::string, DirListing> delivered;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::string> requests;
+    std::deque<std::pair<std::string, DirListing>> results;
+    bool stopping;
+    std::thread thread;
+
+    void run();
+    std::string getPath(const std::string& relPath) const;
+    const IgnoreFrame* getFrame(const std::string& relPath, uint64_t& rulesStamp);
+    bool list(const std::string& relPath, DirListing& listing);
+
+public:
+    DirLister(const std::string& root, uint64_t sizeLimit, bool useIgnoreFiles);
+    ~DirLister();
+
+    const std::string& getRoot() const;
+
+    // `relPath` is "" for the root or a directory path ending in "/"
+    void request(const std::string& relPath);
+
+    // returns false if no listing has finished since the last call;
+    // requests for unchanged directories produce no listing
+    bool poll(std::string& relPath, DirListing& listing);
+};
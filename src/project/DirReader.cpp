@@ -0,0 +1,154 @@
+#include "DirReader.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#define _CRT_INTERNAL_NONSTDC_NAMES 1
+#include <sys/stat.h>
+#if !defined(S_ISDIR) && defined(S_IFMT) && defined(S_IFDIR)
+#define S_ISDIR(m) (((m) & S_IFMT) == S_IFDIR)
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#define PATHSEP '\\'
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#if __linux__
+#include <sys/syscall.h>
+#endif
+#define PATHSEP '/'
+#endif
+
+
+static bool compareEntries(const ProjectEntry& a, const ProjectEntry& b)
+{
+    return a.fileName < b.fileName;
+}
+
+
+bool DirReader::loadIgnoreFrame(const std::string& path, const std::string& relPath, IgnoreFrame& frame)
+{
+    frame.base = relPath;
+    frame.rules.loadFile(path + PATHSEP + ".gitignore");
+    frame.rules.loadFile(path + PATHSEP + ".ignore");
+    return !frame.rules.empty();
+}
+
+bool DirReader::loadExcludeFrame(const std::string& root, IgnoreFrame& frame)
+{
+    frame.base = "";
+    return frame.rules.loadFile(root + PATHSEP + ".git" + PATHSEP + "info" + PATHSEP + "exclude");
+}
+
+bool DirReader::isIgnored(const std::string& relPath, bool isDir, const std::vector<const IgnoreFrame*>& frames)
+{
+    for (auto it = frames.rbegin(); it != frames.rend(); it++)
+    {
+        auto frame = *it;
+        auto verdict = frame->rules.match(std::string_view(relPath).substr(frame->base.size()), isDir);
+        if (verdict != IgnoreVerdict::None)
+            return verdict == IgnoreVerdict::Ignored;
+    }
+    return false;
+}
+
+DirListing DirReader::read(const std::string& path, const std::string& relPath,
+    const std::vector<const IgnoreFrame*>& frames, uint64_t sizeLimit)
+{
+    DirListing listing;
+    listing.modified = getModifiedTime(path);
+
+    std::vector<ProjectEntry> dirs, files;
+    std::error_code ec;
+    for (auto it = std::filesystem::directory_iterator(path, ec); !ec && it != std::filesystem::directory_iterator(); it.increment(ec))
+    {
+        ProjectEntry entry;
+        entry.fileName = it->path().filename().string();
+        if (entry.fileName.empty() || entry.fileName[0] == '.') continue;
+
+        struct stat s;
+        if (stat((path + PATHSEP + entry.fileName).c_str(), &s) < 0 ||
+            (sizeLimit && static_cast<uint64_t>(s.st_size) >= sizeLimit))
+            continue;
+
+        entry.isDir = S_ISDIR(s.st_mode);
+        entry.size = s.st_size;
+        entry.modified = s.st_mtime;
+
+        if (!frames.empty() && isIgnored(relPath + entry.fileName, entry.isDir, frames))
+            continue;
+
+        (entry.isDir ? dirs : files).push_back(std::move(entry));
+    }
+
+    std::sort(dirs.begin(), dirs.end(), compareEntries);
+    std::sort(files.begin(), files.end(), compareEntries);
+    listing.children = std::move(dirs);
+    listing.children.insert(listing.children.end(),
+        std::make_move_iterator(files.begin()), std::make_move_iterator(files.end()));
+    return listing;
+}
+
+bool DirReader::refreshFiles(const std::string& path, DirListing& listing, uint64_t sizeLimit, bool& changed)
+{
+    for (auto& entry : listing.children)
+    {
+        if (entry.isDir) continue;
+
+        struct stat s;
+        if (stat((path + PATHSEP + entry.fileName).c_str(), &s) < 0 || S_ISDIR(s.st_mode) ||
+            (sizeLimit && static_cast<uint64_t>(s.st_size) >= sizeLimit))
+            return false;
+
+        if (entry.size != static_cast<uint64_t>(s.st_size) || entry.modified != s.st_mtime)
+        {
+            entry.size = s.st_size;
+            entry.modified = s.st_mtime;
+            changed = true;
+        }
+    }
+    return true;
+}
+
+int64_t DirReader::getModifiedTime(const std::string& path)
+{
+    struct stat s;
+    return stat(path.c_str(), &s) == 0 ? s.st_mtime : -1;
+}
+
+static uint64_t stampFile(const std::string& file, uint64_t stamp)
+{
+    struct stat s;
+    int64_t values[2] = { -1, -1 };
+    if (stat(file.c_str(), &s) == 0)
+    {
+        values[0] = s.st_mtime;
+        values[1] = s.st_size;
+    }
+
+    // 64bit fnv-1a
+    auto p = reinterpret_cast<const uint8_t*>(values);
+    for (size_t i = 0; i < sizeof(values); i++)
+        stamp = (stamp ^ p[i]) * 1099511628211ull;
+    return stamp;
+}
+
+uint64_t DirReader::stampIgnoreFiles(const std::string& path, bool root, uint64_t stamp)
+{
+    if (root)
+        return stampFile(path + PATHSEP + ".git" + PATHSEP + "info" + PATHSEP + "exclude", stamp);
+    stamp = stampFile(path + PATHSEP + ".gitignore", stamp);
+    return stampFile(path + PATHSEP + ".ignore", stamp);
+}
+
+void DirReader::lowerThreadPriority()
+{
+#ifdef _WIN32
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif __linux__
+    // linux applies nice values per thread
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+#endif
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "IgnoreRules.h"
+#include "ProjectIndex.h"
+
+// The ignore rules of one directory; `base` is the directory's path
+// relative to the project root.
+struct IgnoreFrame
+{
+    std::string base;
+    IgnoreRules rules;
+};
+
+// Directory listing shared by the full project scan and the on-demand
+// tree view listings, so both apply the same filtering and ordering.
+class DirReader
+{
+public:
+    // loads `.gitignore` and `.ignore` from `path`; returns false if the
+    // directory has no rules
+    static bool loadIgnoreFrame(const std::string& path, const std::string& relPath, IgnoreFrame& frame);
+
+    // loads `.git/info/exclude` from the project root
+    static bool loadExcludeFrame(const std::string& root, IgnoreFrame& frame);
+
+    // deeper frames take precedence over the ones before them
+    static bool isIgnored(const std::string& relPath, bool isDir, const std::vector<const IgnoreFrame*>& frames);
+
+    // lists `path`, skipping dot files, entries at or above `sizeLimit`
+    // (unless 0) and ignored entries; directories come first and both
+    // groups are sorted by name
+    static DirListing read(const std::string& path, const std::string& relPath,
+        const std::vector<const IgnoreFrame*>& frames, uint64_t sizeLimit);
+
+    static int64_t getModifiedTime(const std::string& path);
+
+    // restats the files of a listing of `path` whose entries are known to
+    // be unchanged, since rewriting a file in place leaves its directory's
+    // mtime alone; returns false if a file is gone or now at or above
+    // `sizeLimit`, in which case the directory must be read again.
+    // `changed` is set if any size or mtime was updated
+    static bool refreshFiles(const std::string& path, DirListing& listing, uint64_t sizeLimit, bool& changed);
+
+    // mixes the mtime and size of the ignore files of `path` (or of
+    // `.git/info/exclude` if `root`) into `stamp`; editing an ignore file in
+    // place leaves its directory's mtime alone but changes the stamp
+    static uint64_t stampIgnoreFiles(const std::string& path, bool root, uint64_t stamp);
+
+    // used by background threads which must not compete with the UI
+    static void lowerThreadPriority();
+};
@@ -0,0 +1,242 @@
+#include "IgnoreRules.h"
+
+#include <fstream>
+
+
+#pragma region GLOB PATTERN
+bool GlobPattern::compile(std::string_view line)
+{
+    // trailing whitespace is ignored unless escaped
+    while (!line.empty() && (line.back() == ' ' || line.back() == '\r' || line.back() == '\t'))
+    {
+        if (line.size() >= 2 && line[line.size() - 2] == '\\') break;
+        line.remove_suffix(1);
+    }
+
+    if (line.empty() || line[0] == '#') return false;
+
+    negated = line[0] == '!';
+    if (negated) line.remove_prefix(1);
+    else if (line[0] == '\\' && line.size() > 1 && (line[1] == '#' || line[1] == '!')) line.remove_prefix(1);
+
+    directoryOnly = !line.empty() && line.back() == '/';
+    if (directoryOnly) line.remove_suffix(1);
+
+    // a slash anywhere but the end anchors the pattern to the ignore file's
+    // directory, otherwise it matches a name at any depth
+    anchored = line.find('/') != std::string_view::npos;
+    if (!line.empty() && line[0] == '/') line.remove_prefix(1);
+    if (line.empty()) return false;
+
+    tokens.clear();
+    for (size_t i = 0; i < line.size(); i++)
+    {
+        auto c = line[i];
+        if (c == '*')
+        {
+            // `**` only spans directories as a whole path segment
+            bool segmentStart = i == 0 || line[i - 1] == '/';
+            if (i + 1 < line.size() && line[i + 1] == '*' && segmentStart &&
+                (i + 2 == line.size() || line[i + 2] == '/'))
+            {
+                tokens.push_back(Token{ TokenType::DoubleStar });
+                i += (i + 2 < line.size()) ? 2 : 1;
+            }
+            else
+            {
+                while (i + 1 < line.size() && line[i + 1] == '*') i++;
+                tokens.push_back(Token{ TokenType::Star });
+            }
+        }
+        else if (c == '?')
+        {
+            tokens.push_back(Token{ TokenType::Question });
+        }
+        else if (c == '[' && line.find(']', i + 2) != std::string_view::npos)
+        {
+            Token token{ TokenType::Class };
+            i++;
+            bool invert = line[i] == '!' || line[i] == '^';
+            if (invert) i++;
+
+            for (bool first = true; i < line.size() && (first || line[i] != ']'); first = false, i++)
+            {
+                unsigned char lo = line[i];
+                if (i + 2 < line.size() && line[i + 1] == '-' && line[i + 2] != ']')
+                {
+                    unsigned char hi = line[i + 2];
+                    for (unsigned ch = lo; ch <= hi; ch++) token.set.set(ch);
+                    i += 2;
+                }
+                else
+                {
+                    token.set.set(lo);
+                }
+            }
+
+            if (invert) token.set.flip();
+            token.set.reset('/');
+            tokens.push_back(std::move(token));
+        }
+        else
+        {
+            if (c == '\\' && i + 1 < line.size()) c = line[++i];
+            if (tokens.empty() || tokens.back().type != TokenType::Literal)
+            {
+                tokens.push_back(Token{ TokenType::Literal });
+            }
+            tokens.back().text.push_back(c);
+        }
+    }
+
+    // `**/name` matches `name` at any depth, same as an unanchored pattern
+    if (tokens.size() == 2 && tokens[0].type == TokenType::DoubleStar &&
+        tokens[1].type == TokenType::Literal && tokens[1].text.find('/') == std::string::npos)
+    {
+        tokens.erase(tokens.begin());
+        anchored = false;
+    }
+
+    if (tokens.size() == 1 && tokens[0].type == TokenType::Literal && !anchored)
+    {
+        kind = Kind::Literal;
+        literal = tokens[0].text;
+    }
+    else if (tokens.size() == 2 && tokens[0].type == TokenType::Star &&
+        tokens[1].type == TokenType::Literal && !anchored)
+    {
+        kind = Kind::Suffix;
+        literal = tokens[1].text;
+    }
+    else
+    {
+        kind = Kind::Glob;
+    }
+
+    return true;
+}
+
+bool GlobPattern::matchTokens(size_t token, std::string_view path) const
+{
+    while (token < tokens.size())
+    {
+        auto& t = tokens[token];
+        switch (t.type)
+        {
+        case TokenType::Literal:
+            if (path.compare(0, t.text.size(), t.text) != 0) return false;
+            path.remove_prefix(t.text.size());
+            break;
+
+        case TokenType::Question:
+            if (path.empty() || path[0] == '/') return false;
+            path.remove_prefix(1);
+            break;
+
+        case TokenType::Class:
+            if (path.empty() || !t.set.test(static_cast<unsigned char>(path[0]))) return false;
+            path.remove_prefix(1);
+            break;
+
+        case TokenType::Star:
+            if (token + 1 == tokens.size()) return path.find('/') == std::string_view::npos;
+            for (size_t i = 0; i <= path.size(); i++)
+            {
+                if (matchTokens(token + 1, path.substr(i))) return true;
+                if (i < path.size() && path[i] == '/') break;
+            }
+            return false;
+
+        case TokenType::DoubleStar:
+            // matches zero or more whole directories
+            if (token + 1 == tokens.size()) return true;
+            for (size_t i = 0; i <= path.size(); i++)
+            {
+                if ((i == 0 || path[i - 1] == '/') && matchTokens(token + 1, path.substr(i))) return true;
+            }
+            return false;
+        }
+        token++;
+    }
+
+    return path.empty();
+}
+
+bool GlobPattern::match(std::string_view path, std::string_view name) const
+{
+    switch (kind)
+    {
+    case Kind::Literal:
+        return name == literal;
+    case Kind::Suffix:
+        return name.size() >= literal.size() &&
+            name.compare(name.size() - literal.size(), literal.size(), literal) == 0;
+    default:
+        return matchTokens(0, anchored ? path : name);
+    }
+}
+#pragma endregion
+
+
+#pragma region IGNORE RULES
+IgnoreRules::IgnoreRules() : hasNegations(false)
+{
+}
+
+void IgnoreRules::addPattern(std::string_view line)
+{
+    GlobPattern pattern;
+    if (!pattern.compile(line)) return;
+
+    hasNegations = hasNegations || pattern.negated;
+
+    // without negations the order of plain names does not matter, so they
+    // are looked up in a set instead of being tested one by one
+    if (pattern.kind == GlobPattern::Kind::Literal && !pattern.negated && !pattern.directoryOnly)
+    {
+        literalNames.insert(pattern.literal);
+    }
+
+    patterns.push_back(std::move(pattern));
+}
+
+bool IgnoreRules::loadFile(const std::string& fileName)
+{
+    auto file = std::ifstream(fileName, std::ios::in | std::ios::binary);
+    if (!file.is_open()) return false;
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        addPattern(line);
+    }
+    return true;
+}
+
+bool IgnoreRules::empty() const
+{
+    return patterns.empty();
+}
+
+IgnoreVerdict IgnoreRules::match(std::string_view path, bool isDir) const
+{
+    auto slash = path.rfind('/');
+    auto name = slash == std::string_view::npos ? path : path.substr(slash + 1);
+
+    if (!hasNegations && literalNames.count(std::string(name)))
+    {
+        return IgnoreVerdict::Ignored;
+    }
+
+    for (auto it = patterns.rbegin(); it != patterns.rend(); it++)
+    {
+        if (it->directoryOnly && !isDir) continue;
+        if (it->match(path, name))
+        {
+            return it->negated ? IgnoreVerdict::Included : IgnoreVerdict::Ignored;
+        }
+    }
+
+    return IgnoreVerdict::None;
+}
+#pragma endregion
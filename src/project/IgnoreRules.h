@@ -0,0 +1,60 @@
+#pragma once
+
+#include <bitset>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+enum class IgnoreVerdict { None, Ignored, Included };
+
+// A compiled gitignore glob. Plain names and `*.ext` patterns, which make up
+// most real ignore files, are matched without running the glob matcher.
+class GlobPattern
+{
+private:
+    enum class TokenType { Literal, Star, DoubleStar, Question, Class };
+
+    struct Token
+    {
+        TokenType type;
+        std::string text;
+        std::bitset<256> set;
+    };
+
+    std::vector<Token> tokens;
+
+    bool matchTokens(size_t token, std::string_view path) const;
+
+public:
+    enum class Kind { Literal, Suffix, Glob };
+
+    Kind kind;
+    std::string literal;
+    bool negated;
+    bool directoryOnly;
+    bool anchored;
+
+    // returns false for blank lines and comments
+    bool compile(std::string_view line);
+    bool match(std::string_view path, std::string_view name) const;
+};
+
+// The rules of the ignore files found in one directory, matched against
+// paths relative to that directory. The last matching pattern wins.
+class IgnoreRules
+{
+private:
+    std::vector<GlobPattern> patterns;
+    std::unordered_set<std::string> literalNames;
+    bool hasNegations;
+
+public:
+    IgnoreRules();
+
+    void addPattern(std::string_view line);
+    bool loadFile(const std::string& fileName);
+    bool empty() const;
+
+    IgnoreVerdict match(std::string_view path, bool isDir) const;
+};
@@ -0,0 +1,129 @@
+#include "ProjectIndex.h"
+
+#include <string.h>
+#include <filesystem>
+#include <fstream>
+
+#define INDEX_MAGIC "LXTIDX02"
+
+
+#pragma region HELPER FUNCTIONS
+template <typename T>
+static void writeValue(std::ofstream& file, T value)
+{
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+static void writeString(std::ofstream& file, const std::string& str)
+{
+    writeValue<uint32_t>(file, static_cast<uint32_t>(str.size()));
+    file.write(str.data(), str.size());
+}
+
+template <typename T>
+static bool readValue(std::ifstream& file, T& value)
+{
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+static bool readString(std::ifstream& file, std::string& str)
+{
+    uint32_t len;
+    if (!readValue(file, len) || len > (1u << 20)) return false;
+    str.resize(len);
+    return static_cast<bool>(file.read(&str[0], len));
+}
+#pragma endregion
+
+
+ProjectIndex::ProjectIndex() : sizeLimit(0), useIgnoreFiles(true)
+{
+}
+
+bool ProjectIndex::load(const std::string& fileName)
+{
+    auto file = std::ifstream(fileName, std::ios::in | std::ios::binary);
+    if (!file.is_open()) return false;
+
+    char magic[8];
+    if (!file.read(magic, sizeof(magic)) || memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0)
+        return false;
+
+    std::string fileRoot;
+    uint64_t fileSizeLimit;
+    uint8_t fileUseIgnoreFiles;
+    uint32_t dirCount;
+    if (!readString(file, fileRoot) || !readValue(file, fileSizeLimit) ||
+        !readValue(file, fileUseIgnoreFiles) || !readValue(file, dirCount))
+        return false;
+
+    if (fileRoot != root || fileSizeLimit != sizeLimit || (fileUseIgnoreFiles != 0) != useIgnoreFiles)
+        return false;
+
+    std::unordered_map<std::string, DirListing> loaded;
+    for (uint32_t i = 0; i < dirCount; i++)
+    {
+        std::string relPath;
+        DirListing listing;
+        uint32_t childCount;
+        if (!readString(file, relPath) || !readValue(file, listing.modified) ||
+            !readValue(file, listing.rulesStamp) || !readValue(file, childCount))
+            return false;
+
+        listing.children.resize(childCount);
+        for (auto& child : listing.children)
+        {
+            uint8_t isDir;
+            if (!readString(file, child.fileName) || !readValue(file, isDir) ||
+                !readValue(file, child.size) || !readValue(file, child.modified))
+                return false;
+            child.isDir = isDir != 0;
+        }
+
+        loaded.emplace(std::move(relPath), std::move(listing));
+    }
+
+    dirs = std::move(loaded);
+    return true;
+}
+
+bool ProjectIndex::save(const std::string& fileName) const
+{
+    std::error_code ec;
+    auto parent = std::filesystem::path(fileName).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent, ec);
+
+    // write to a temporary file first so a crash never leaves a truncated
+    // index behind
+    auto tempName = fileName + ".tmp";
+    {
+        auto file = std::ofstream(tempName, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+
+        file.write(INDEX_MAGIC, 8);
+        writeString(file, root);
+        writeValue<uint64_t>(file, sizeLimit);
+        writeValue<uint8_t>(file, useIgnoreFiles);
+        writeValue<uint32_t>(file, static_cast<uint32_t>(dirs.size()));
+
+        for (auto& [relPath, listing] : dirs)
+        {
+            writeString(file, relPath);
+            writeValue<int64_t>(file, listing.modified);
+            writeValue<uint64_t>(file, listing.rulesStamp);
+            writeValue<uint32_t>(file, static_cast<uint32_t>(listing.children.size()));
+            for (auto& child : listing.children)
+            {
+                writeString(file, child.fileName);
+                writeValue<uint8_t>(file, child.isDir);
+                writeValue<uint64_t>(file, child.size);
+                writeValue<int64_t>(file, child.modified);
+            }
+        }
+
+        if (!file.good()) return false;
+    }
+
+    std::filesystem::rename(tempName, fileName, ec);
+    return !ec;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ProjectEntry
+{
+    std::string fileName;
+    bool isDir;
+    uint64_t size;
+    int64_t modified;
+};
+
+// The children of one directory, directories first, each group sorted by
+// name. `fileName` only holds the entry's name.
+struct DirListing
+{
+    int64_t modified;
+
+    // identifies the ignore files applied to the listing, see
+    // DirReader::stampIgnoreFiles
+    uint64_t rulesStamp = 0;
+
+    std::vector<ProjectEntry> children;
+};
+
+// Every directory listing of a project keyed by its path relative to the
+// project root ("" for the root, "src/" for a subdirectory). It can be
+// saved to and loaded from a compact binary file so the next launch can
+// show the project before it has been rescanned.
+class ProjectIndex
+{
+public:
+    std::string root;
+    uint64_t sizeLimit;
+    bool useIgnoreFiles;
+    std::unordered_map<std::string, DirListing> dirs;
+
+    ProjectIndex();
+
+    // fails if the file is missing, corrupt, or was written with other
+    // scan options
+    bool load(const std::string& fileName);
+    bool save(const std::string& fileName) const;
+};
@@ -0,0 +1,133 @@
+#include "ProjectScanner.h"
+#include "../scheduler/Wakeup.h"
+
+#ifdef _WIN32
+#define PATHSEP '\\'
+#else
+#define PATHSEP '/'
+#endif
+
+
+ProjectScanner::ProjectScanner(const std::string& root, uint64_t sizeLimit, bool useIgnoreFiles,
+    const std::string& cacheFile, bool lowPriority)
+    : cacheFile(cacheFile), lowPriority(lowPriority), reusedDirs(0), previousDirs(0), refreshedFiles(false),
+    cacheLoaded(false), done(false), cancelled(false)
+{
+    index.root = previous.root = root;
+    index.sizeLimit = previous.sizeLimit = sizeLimit;
+    index.useIgnoreFiles = previous.useIgnoreFiles = useIgnoreFiles;
+    Wakeup::getEventType();
+    thread = std::thread(&ProjectScanner::run, this);
+}
+
+ProjectScanner::~ProjectScanner()
+{
+    cancelled = true;
+    if (thread.joinable())
+        thread.join();
+}
+
+void ProjectScanner::run()
+{
+    if (lowPriority)
+        DirReader::lowerThreadPriority();
+
+    if (!cacheFile.empty() && previous.load(cacheFile))
+    {
+        cachedTree = std::make_unique<ProjectTree>(previous);
+        previousDirs = previous.dirs.size();
+        cacheLoaded = true;
+        Wakeup::post();
+    }
+
+    std::vector<const IgnoreFrame*> frames;
+    IgnoreFrame exclude;
+    uint64_t rulesStamp = 0;
+    if (index.useIgnoreFiles)
+    {
+        if (DirReader::loadExcludeFrame(index.root, exclude))
+            frames.push_back(&exclude);
+        rulesStamp = DirReader::stampIgnoreFiles(index.root, true, 0);
+    }
+
+    scanDir(index.root, "", frames, rulesStamp);
+    if (cancelled) return;
+
+    tree = std::make_unique<ProjectTree>(index);
+
+    // only rewrite the cache if some directory had to be listed again or
+    // some file was rewritten
+    bool changed = reusedDirs != previousDirs || reusedDirs != index.dirs.size() || refreshedFiles;
+    if (!cacheFile.empty() && changed)
+        index.save(cacheFile);
+
+    previous.dirs.clear();
+    done = true;
+    Wakeup::post();
+}
+
+void ProjectScanner::scanDir(const std::string& path, const std::string& relPath, std::vector<const IgnoreFrame*>& frames, uint64_t rulesStamp)
+{
+    if (cancelled) return;
+
+    IgnoreFrame frame;
+    bool hasFrame = index.useIgnoreFiles && DirReader::loadIgnoreFrame(path, relPath, frame);
+    if (hasFrame)
+        frames.push_back(&frame);
+    if (index.useIgnoreFiles)
+        rulesStamp = DirReader::stampIgnoreFiles(path, false, rulesStamp);
+
+    // a directory's mtime only changes when entries are added, removed or
+    // renamed, so an unchanged directory whose ignore files (its own and
+    // its parents') are unchanged too can reuse its previous entries; files
+    // rewritten in place are caught by restating them
+    DirListing listing;
+    auto modified = DirReader::getModifiedTime(path);
+    auto cached = previous.dirs.find(relPath);
+    bool reused = false;
+    if (cached != previous.dirs.end() && cached->second.modified == modified && modified != -1 &&
+        cached->second.rulesStamp == rulesStamp)
+    {
+        listing = std::move(cached->second);
+        reused = DirReader::refreshFiles(path, listing, index.sizeLimit, refreshedFiles);
+        if (reused) reusedDirs++;
+    }
+    if (!reused)
+    {
+        listing = DirReader::read(path, relPath, frames, index.sizeLimit);
+        listing.rulesStamp = rulesStamp;
+    }
+
+    for (auto& child : listing.children)
+    {
+        if (child.isDir)
+            scanDir(path + PATHSEP + child.fileName, relPath + child.fileName + "/", frames, rulesStamp);
+    }
+
+    index.dirs[relPath] = std::move(listing);
+
+    if (hasFrame)
+        frames.pop_back();
+}
+
+bool ProjectScanner::isDone() const
+{
+    return done;
+}
+
+bool ProjectScanner::hasCachedTree() const
+{
+    return cacheLoaded;
+}
+
+std::unique_ptr<ProjectTree> ProjectScanner::takeCachedTree()
+{
+    if (!cacheLoaded) return nullptr;
+    return std::move(cachedTree);
+}
+
+std::unique_ptr<ProjectTree> ProjectScanner::takeTree()
+{
+    if (!done) return nullptr;
+    return std::move(tree);
+}
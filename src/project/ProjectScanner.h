@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DirReader.h"
+#include "ProjectIndex.h"
+#include "ProjectTree.h"
+
+// Recursively lists a project directory on a background thread. Entries
+// are ordered like the tree view shows them: each directory is followed by
+// its contents, directories before files, both sorted by name. Paths matched
+// by `.gitignore` / `.ignore` files are left out.
+//
+// If a cache file is given, the previous index is loaded from it first and
+// made available straight away; the scan then only re-lists directories
+// whose modification time or applicable ignore files changed, restats the
+// files of the others, and writes the result back. A wakeup is posted when the cached tree and when the
+// scanned tree become available.
+class ProjectScanner
+{
+private:
+    std::string cacheFile;
+    bool lowPriority;
+    ProjectIndex previous;
+    ProjectIndex index;
+
+    size_t reusedDirs;
+    size_t previousDirs;
+    bool refreshedFiles;
+    std::unique_ptr<ProjectTree> cachedTree;
+    std::unique_ptr<ProjectTree> tree;
+    std::atomic<bool> cacheLoaded;
+    std::atomic<bool> done;
+    std::atomic<bool> cancelled;
+    std::thread thread;
+
+    void run();
+    void scanDir(const std::string& path, const std::string& relPath, std::vector<const IgnoreFrame*>& frames, uint64_t rulesStamp);
+
+public:
+    // a `sizeLimit` of 0 lists entries of any size; an empty `cacheFile`
+    // disables the persistent index; a `lowPriority` scan runs on a thread
+    // with a lowered OS priority
+    ProjectScanner(const std::string& root, uint64_t sizeLimit, bool useIgnoreFiles,
+        const std::string& cacheFile = "", bool lowPriority = false);
+    ~ProjectScanner();
+
+    bool isDone() const;
+    bool hasCachedTree() const;
+
+    // hands over the tree loaded from the cache; null before
+    // `hasCachedTree()` returns true or if it was already taken
+    std::unique_ptr<ProjectTree> takeCachedTree();
+
+    // hands over the scanned tree; null before `isDone()` returns true or
+    // if it was already taken
+    std::unique_ptr<ProjectTree> takeTree();
+};
@@ -0,0 +1,184 @@
+#include "ProjectTree.h"
+
+#ifdef _WIN32
+#define PATHSEP '\\'
+#else
+#define PATHSEP '/'
+#endif
+
+
+ProjectTree::ProjectTree()
+{
+}
+
+ProjectTree::ProjectTree(const ProjectIndex& index) : root(index.root)
+{
+    addDir(index, "", PROJECT_NO_PARENT, 0);
+    nodes.shrink_to_fit();
+}
+
+uint32_t ProjectTree::intern(const std::string& name)
+{
+    auto it = nameIds.find(name);
+    if (it != nameIds.end()) return it->second;
+
+    auto id = static_cast<uint32_t>(names.size());
+    names.push_back(name);
+    nameIds.emplace(names.back(), id);
+    return id;
+}
+
+void ProjectTree::addDir(const ProjectIndex& index, const std::string& relPath, uint32_t parent, uint16_t depth)
+{
+    auto it = index.dirs.find(relPath);
+    if (it == index.dirs.end()) return;
+
+    for (auto& child : it->second.children)
+    {
+        auto idx = static_cast<uint32_t>(nodes.size());
+        ProjectNode node;
+        node.name = intern(child.fileName);
+        node.parent = parent;
+        node.end = idx + 1;
+        node.modified = static_cast<uint32_t>(child.modified);
+        node.size = child.size;
+        node.depth = depth;
+        node.isDir = child.isDir;
+        nodes.push_back(node);
+
+        if (child.isDir)
+        {
+            addDir(index, relPath + child.fileName + "/", idx, depth + 1);
+            nodes[idx].end = static_cast<uint32_t>(nodes.size());
+        }
+    }
+}
+
+size_t ProjectTree::size() const
+{
+    return nodes.size();
+}
+
+const ProjectNode& ProjectTree::getNode(size_t idx) const
+{
+    return nodes[idx];
+}
+
+const std::string& ProjectTree::getName(size_t idx) const
+{
+    return names[nodes[idx].name];
+}
+
+std::string ProjectTree::getRelativePath(size_t idx, char separator) const
+{
+    size_t len = 0;
+    for (auto i = static_cast<uint32_t>(idx); i != PROJECT_NO_PARENT; i = nodes[i].parent)
+    {
+        len += names[nodes[i].name].size() + 1;
+    }
+
+    // fill the path from the back, walking up the parents
+    std::string path(len - 1, separator);
+    auto pos = path.size();
+    for (auto i = static_cast<uint32_t>(idx); i != PROJECT_NO_PARENT; i = nodes[i].parent)
+    {
+        auto& name = names[nodes[i].name];
+        pos -= name.size();
+        path.replace(pos, name.size(), name);
+        if (pos > 0) pos--;
+    }
+    return path;
+}
+
+std::string ProjectTree::getFileName(size_t idx) const
+{
+    return root + PATHSEP + getRelativePath(idx, PATHSEP);
+}
+
+int64_t ProjectTree::find(std::string_view relPath) const
+{
+    size_t first = 0, last = nodes.size();
+    int64_t found = -1;
+
+    while (!relPath.empty())
+    {
+        auto sep = relPath.find_first_of("/\\");
+        auto name = relPath.substr(0, sep);
+        relPath = sep == std::string_view::npos ? std::string_view() : relPath.substr(sep + 1);
+        if (name.empty()) continue;
+
+        // scan the siblings, jumping over each one's subtree
+        found = -1;
+        for (auto i = first; i < last; i = nodes[i].end)
+        {
+            if (names[nodes[i].name] == name)
+            {
+                found = static_cast<int64_t>(i);
+                break;
+            }
+        }
+
+        if (found < 0) return -1;
+        first = found + 1;
+        last = nodes[found].end;
+    }
+
+    return found;
+}
+
+void ProjectTree::spliceDir(const ProjectIndex& index, const std::string& relPath, uint32_t dir)
+{
+    uint32_t first = 0, last = static_cast<uint32_t>(nodes.size());
+    uint16_t depth = 0;
+    if (dir != PROJECT_NO_PARENT)
+    {
+        first = dir + 1;
+        last = nodes[dir].end;
+        depth = nodes[dir].depth + 1;
+    }
+
+    // rebuild the subtree in place and put the nodes after it back, moving
+    // their links by the difference
+    std::vector<ProjectNode> tail(nodes.begin() + last, nodes.end());
+    nodes.resize(first);
+    addDir(index, relPath, dir, depth);
+    auto delta = static_cast<int64_t>(nodes.size()) - last;
+
+    for (auto node : tail)
+    {
+        if (node.parent != PROJECT_NO_PARENT && node.parent >= last)
+            node.parent = static_cast<uint32_t>(node.parent + delta);
+        node.end = static_cast<uint32_t>(node.end + delta);
+        nodes.push_back(node);
+    }
+    for (auto i = dir; i != PROJECT_NO_PARENT; i = nodes[i].parent)
+    {
+        nodes[i].end = static_cast<uint32_t>(nodes[i].end + delta);
+    }
+}
+
+bool ProjectTree::equals(const ProjectTree& other) const
+{
+    if (root != other.root || nodes.size() != other.nodes.size()) return false;
+
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        auto& a = nodes[i];
+        auto& b = other.nodes[i];
+        if (a.modified != b.modified || a.parent != b.parent || a.isDir != b.isDir ||
+            names[a.name] != other.names[b.name])
+            return false;
+    }
+    return true;
+}
+
+size_t ProjectTree::getMemoryUsage() const
+{
+    size_t total = sizeof(ProjectTree) + nodes.capacity() * sizeof(ProjectNode);
+    for (auto& name : names)
+    {
+        total += sizeof(std::string) + name.capacity();
+    }
+    total += nameIds.size() * (sizeof(std::string_view) + sizeof(uint32_t) + 2 * sizeof(void*));
+    return total;
+}
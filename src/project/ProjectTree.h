@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "ProjectIndex.h"
+
+#define PROJECT_NO_PARENT UINT32_MAX
+
+// One file or directory; 24 bytes no matter how long its path is.
+struct ProjectNode
+{
+    uint32_t name;
+    uint32_t parent;
+    uint32_t end;
+    uint32_t modified;
+    uint64_t size : 47;
+    uint64_t depth : 16;
+    uint64_t isDir : 1;
+};
+
+// Compact store of every file in a project. Nodes are laid out in tree
+// order (each directory followed by its contents, directories before
+// files), so a node's subtree is the range [index + 1, end). Path
+// components are interned, and full paths are only built on request.
+class ProjectTree
+{
+private:
+    std::string root;
+    std::deque<std::string> names;
+    std::unordered_map<std::string_view, uint32_t> nameIds;
+    std::vector<ProjectNode> nodes;
+
+    uint32_t intern(const std::string& name);
+    void addDir(const ProjectIndex& index, const std::string& relPath, uint32_t parent, uint16_t depth);
+
+public:
+    ProjectTree();
+    ProjectTree(const ProjectIndex& index);
+
+    size_t size() const;
+    const ProjectNode& getNode(size_t idx) const;
+    const std::string& getName(size_t idx) const;
+
+    // `root` + separator + relative path, as the scan used to report it
+    std::string getFileName(size_t idx) const;
+    std::string getRelativePath(size_t idx, char separator) const;
+
+    // accepts either separator; returns -1 if there is no such entry
+    int64_t find(std::string_view relPath) const;
+
+    // replaces the contents of the directory node `dir` (or of the whole
+    // tree for PROJECT_NO_PARENT) with `index`'s listings from `relPath`
+    // down; nodes after it move by the change in the subtree's size
+    void spliceDir(const ProjectIndex& index, const std::string& relPath, uint32_t dir);
+
+    bool equals(const ProjectTree& other) const;
+    size_t getMemoryUsage() const;
+};
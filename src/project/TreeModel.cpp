@@ -0,0 +1,181 @@
+#include "TreeModel.h"
+
+#include <algorithm>
+
+
+static const ProjectTree emptyTree;
+
+TreeModel::TreeModel() : tree(&emptyTree)
+{
+}
+
+void TreeModel::setTree(const ProjectTree* tree)
+{
+    this->tree = tree ? tree : &emptyTree;
+    ownTree.reset();
+    updateExpandedNodes();
+    updateRows();
+}
+
+void TreeModel::setListing(const std::string& root, const std::string& relPath, DirListing&& listing)
+{
+    listings.root = root;
+    listings.dirs[relPath] = std::move(listing);
+    pending.push_back(relPath);
+}
+
+bool TreeModel::applyListings()
+{
+    if (pending.empty()) return false;
+
+    std::sort(pending.begin(), pending.end());
+    pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+
+    if (!ownTree || pending.front().empty())
+    {
+        // the root listing covers everything, so build the tree once
+        ownTree.reset(new ProjectTree(listings));
+        tree = ownTree.get();
+        updateExpandedNodes();
+        updateRows();
+    }
+    else
+    {
+        // a directory's subtree includes any queued directories below it,
+        // which sort right after it
+        const std::string* spliced = nullptr;
+        for (auto& relPath : pending)
+        {
+            if (spliced && relPath.compare(0, spliced->size(), *spliced) == 0) continue;
+            spliceListing(relPath);
+            spliced = &relPath;
+        }
+    }
+
+    pending.clear();
+    return true;
+}
+
+void TreeModel::spliceListing(const std::string& relPath)
+{
+    auto found = tree->find(relPath);
+    if (found < 0 || !tree->getNode(found).isDir) return;
+
+    auto dir = static_cast<uint32_t>(found);
+    auto first = dir + 1;
+    auto oldEnd = tree->getNode(dir).end;
+    ownTree->spliceDir(listings, relPath, dir);
+    auto newEnd = tree->getNode(dir).end;
+    auto delta = static_cast<int64_t>(newEnd) - oldEnd;
+
+    expandedNodes.erase(expandedNodes.begin() + first, expandedNodes.begin() + oldEnd);
+    expandedNodes.insert(expandedNodes.begin() + first, newEnd - first, 0);
+    for (auto& path : expanded)
+    {
+        if (path.size() <= relPath.size() || path.compare(0, relPath.size(), relPath) != 0) continue;
+        auto idx = tree->find(path);
+        if (idx >= 0 && tree->getNode(idx).isDir) expandedNodes[idx] = 1;
+    }
+
+    // only the directory's own rows change; the ones after it move
+    auto begin = std::lower_bound(rows.begin(), rows.end(), first);
+    auto end = std::lower_bound(begin, rows.end(), oldEnd);
+    bool shown = expandedNodes[dir] && std::binary_search(rows.begin(), begin, dir);
+    auto pos = rows.erase(begin, end) - rows.begin();
+    for (auto it = rows.begin() + pos; it != rows.end(); ++it)
+    {
+        *it = static_cast<uint32_t>(*it + delta);
+    }
+
+    if (shown)
+    {
+        std::vector<uint32_t> added;
+        appendRows(first, newEnd, added);
+        rows.insert(rows.begin() + pos, added.begin(), added.end());
+    }
+}
+
+void TreeModel::updateExpandedNodes()
+{
+    expandedNodes.assign(tree->size(), 0);
+    for (auto& path : expanded)
+    {
+        auto idx = tree->find(path);
+        if (idx >= 0 && tree->getNode(idx).isDir) expandedNodes[idx] = 1;
+    }
+}
+
+void TreeModel::updateRows()
+{
+    rows.clear();
+    appendRows(0, static_cast<uint32_t>(tree->size()), rows);
+}
+
+void TreeModel::appendRows(uint32_t first, uint32_t last, std::vector<uint32_t>& out) const
+{
+    for (uint32_t i = first; i < last; )
+    {
+        out.push_back(i);
+        // collapsed directories jump straight past their subtree
+        i = expandedNodes[i] ? i + 1 : tree->getNode(i).end;
+    }
+}
+
+const ProjectTree& TreeModel::getTree() const
+{
+    return *tree;
+}
+
+size_t TreeModel::getRowCount() const
+{
+    return rows.size();
+}
+
+uint32_t TreeModel::getNodeIndex(size_t row) const
+{
+    return rows[row];
+}
+
+bool TreeModel::isExpanded(size_t row) const
+{
+    return expandedNodes[rows[row]] != 0;
+}
+
+void TreeModel::setExpanded(size_t row, bool expand)
+{
+    auto idx = rows[row];
+    if (!tree->getNode(idx).isDir || (expandedNodes[idx] != 0) == expand) return;
+
+    auto path = tree->getRelativePath(idx, '/');
+    expandedNodes[idx] = expand;
+    if (expand)
+    {
+        expanded.insert(path);
+    }
+    else
+    {
+        expanded.erase(path);
+    }
+    updateRows();
+}
+
+std::vector<std::string> TreeModel::getExpandedPaths() const
+{
+    std::vector<std::string> paths;
+    for (auto& path : expanded)
+    {
+        if (tree->find(path) >= 0) paths.push_back(path);
+    }
+    return paths;
+}
+
+int64_t TreeModel::findRow(std::string_view relPath) const
+{
+    auto idx = tree->find(relPath);
+    if (idx < 0) return -1;
+
+    // rows are kept in tree order, so node indices are ascending
+    auto it = std::lower_bound(rows.begin(), rows.end(), static_cast<uint32_t>(idx));
+    if (it == rows.end() || *it != idx) return -1;
+    return it - rows.begin();
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "ProjectIndex.h"
+#include "ProjectTree.h"
+
+// The rows a tree view shows for a project tree: the top-level entries and
+// the contents of every expanded directory, flattened into one list so a
+// view only has to touch the rows on screen. The tree is either borrowed
+// from a full project scan or built from single directory listings as they
+// arrive. Expanded directories are remembered by path, so they stay open
+// when the tree is replaced.
+class TreeModel
+{
+private:
+    const ProjectTree* tree;
+    std::unique_ptr<ProjectTree> ownTree;
+    ProjectIndex listings;
+    std::vector<std::string> pending;
+
+    std::unordered_set<std::string> expanded;
+    std::vector<uint8_t> expandedNodes;
+    std::vector<uint32_t> rows;
+
+    void updateExpandedNodes();
+    void updateRows();
+    void appendRows(uint32_t first, uint32_t last, std::vector<uint32_t>& out) const;
+    void spliceListing(const std::string& relPath);
+
+public:
+    TreeModel();
+
+    // the tree is not owned and must outlive the model or the next call
+    void setTree(const ProjectTree* tree);
+
+    // queues one directory of the model's own tree for replacement;
+    // `relPath` is "" for the root or a directory path ending in "/"
+    void setListing(const std::string& root, const std::string& relPath, DirListing&& listing);
+
+    // applies the queued listings, splicing each changed directory into
+    // the tree and rows; returns false if none were queued
+    bool applyListings();
+
+    const ProjectTree& getTree() const;
+    size_t getRowCount() const;
+    uint32_t getNodeIndex(size_t row) const;
+
+    bool isExpanded(size_t row) const;
+    void setExpanded(size_t row, bool expand);
+
+    // relative paths of expanded directories present in the current tree
+    std::vector<std::string> getExpandedPaths() const;
+
+    // returns -1 if the entry is missing or inside a collapsed directory
+    int64_t findRow(std::string_view relPath) const;
+};
@@ -0,0 +1,125 @@
+#include "LatencyTracker.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+
+LatencyTracker::LatencyTracker()
+{
+    reset();
+}
+
+void LatencyTracker::reset()
+{
+    memset(histograms, 0, sizeof(histograms));
+    for (auto& time : pending) time = -1;
+}
+
+int LatencyTracker::getBucket(double seconds)
+{
+    double us = seconds * 1e6;
+    if (us <= 1) return 0;
+    int bucket = static_cast<int>(log2(us) * LATENCY_BUCKETS_PER_OCTAVE);
+    return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
+
+double LatencyTracker::getBucketLimit(int bucket)
+{
+    return exp2((bucket + 1) / (double)LATENCY_BUCKETS_PER_OCTAVE) / 1e6;
+}
+
+void LatencyTracker::input(LatencyKind kind, double time)
+{
+    if (pending[kind] < 0 || time < pending[kind]) pending[kind] = time;
+}
+
+void LatencyTracker::frame(bool presented, double time)
+{
+    for (int kind = 0; kind < LATENCY_KINDS; kind++)
+    {
+        if (pending[kind] < 0) continue;
+
+        if (presented)
+        {
+            auto latency = time > pending[kind] ? time - pending[kind] : 0;
+            auto& histogram = histograms[kind];
+            histogram.counts[getBucket(latency)]++;
+            histogram.total++;
+            histogram.sum += latency;
+            if (latency > histogram.max) histogram.max = latency;
+        }
+        pending[kind] = -1;
+    }
+}
+
+uint64_t LatencyTracker::getCount(LatencyKind kind) const
+{
+    return histograms[kind].total;
+}
+
+double LatencyTracker::getMean(LatencyKind kind) const
+{
+    auto& histogram = histograms[kind];
+    return histogram.total ? histogram.sum / histogram.total : 0;
+}
+
+double LatencyTracker::getMax(LatencyKind kind) const
+{
+    return histograms[kind].max;
+}
+
+double LatencyTracker::getPercentile(LatencyKind kind, double p) const
+{
+    auto& histogram = histograms[kind];
+    if (histogram.total == 0) return 0;
+
+    auto rank = static_cast<uint64_t>(ceil(p * histogram.total));
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        seen += histogram.counts[i];
+        if (seen >= rank)
+        {
+            auto limit = getBucketLimit(i);
+            return limit < histogram.max ? limit : histogram.max;
+        }
+    }
+    return histogram.max;
+}
+
+bool LatencyTracker::dump(const char* path) const
+{
+    FILE* fp = fopen(path, "wb");
+    if (!fp) return false;
+
+    fprintf(fp, "# kind count mean_ms p50_ms p90_ms p99_ms max_ms\n");
+    for (int i = 0; i < LATENCY_KINDS; i++)
+    {
+        auto kind = static_cast<LatencyKind>(i);
+        fprintf(fp, "%s %llu %.3f %.3f %.3f %.3f %.3f\n", getKindName(kind),
+            (unsigned long long)getCount(kind), getMean(kind) * 1e3,
+            getPercentile(kind, 0.5) * 1e3, getPercentile(kind, 0.9) * 1e3,
+            getPercentile(kind, 0.99) * 1e3, getMax(kind) * 1e3);
+    }
+
+    fprintf(fp, "\n# kind bucket_limit_ms count\n");
+    for (int i = 0; i < LATENCY_KINDS; i++)
+    {
+        for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++)
+        {
+            auto count = histograms[i].counts[bucket];
+            if (count == 0) continue;
+            fprintf(fp, "%s %.3f %llu\n", getKindName(static_cast<LatencyKind>(i)),
+                getBucketLimit(bucket) * 1e3, (unsigned long long)count);
+        }
+    }
+
+    return fclose(fp) == 0;
+}
+
+const char* LatencyTracker::getKindName(LatencyKind kind)
+{
+    return kind == LATENCY_KEY ? "key" : "pointer";
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+
+// latencies fall in buckets a fraction of an octave wide, from 1us to
+// about 16s, so percentiles are exact to within 9%
+#define LATENCY_BUCKETS_PER_OCTAVE 8
+#define LATENCY_BUCKETS (24 * LATENCY_BUCKETS_PER_OCTAVE)
+
+enum LatencyKind
+{
+    LATENCY_KEY,
+    LATENCY_POINTER,
+    LATENCY_KINDS
+};
+
+// Measures input-to-photon latency: the time from SDL receiving an input
+// event to the window surface update of the first frame drawn after it.
+// A frame which changes nothing on screen shows no effect of the input,
+// which is then dropped rather than blamed on a later frame.
+class LatencyTracker
+{
+private:
+    struct Histogram
+    {
+        uint64_t counts[LATENCY_BUCKETS];
+        uint64_t total;
+        double sum;
+        double max;
+    };
+
+    Histogram histograms[LATENCY_KINDS];
+
+    // the earliest input not yet on screen, or -1
+    double pending[LATENCY_KINDS];
+
+    static int getBucket(double seconds);
+    static double getBucketLimit(int bucket);
+
+public:
+    LatencyTracker();
+
+    // `time` is on the `system.get_time` clock
+    void input(LatencyKind kind, double time);
+    void frame(bool presented, double time);
+    void reset();
+
+    uint64_t getCount(LatencyKind kind) const;
+    double getMean(LatencyKind kind) const;
+    double getMax(LatencyKind kind) const;
+
+    // `p` from 0 to 1; the upper limit of the bucket holding it
+    double getPercentile(LatencyKind kind, double p) const;
+
+    // writes a summary and the non-empty buckets of each kind as text
+    bool dump(const char* path) const;
+
+    static const char* getKindName(LatencyKind kind);
+};
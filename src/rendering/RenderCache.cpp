@@ -1,4 +1,8 @@
+#include <stdio.h>
+#include <algorithm>
+
 #include "RenderCache.h"
+#include "../profiler/Profiler.h"
 
 
 enum { FREE_FONT, SET_CLIP, DRAW_TEXT, DRAW_RECT };
@@ -45,11 +49,21 @@ static RenRect mergeRects(RenRect a, RenRect b) {
 #pragma endregion
 
 
-RenderCache::RenderCache(Renderer& renderer) : renderer(renderer), rectBuffer(std::vector<RenRect>(CELLS_X * CELLS_Y / 2)),
-    cellsBuffer1(std::vector<uint32_t>(CELLS_X * CELLS_Y)), cellsBuffer2(std::vector<uint32_t>(CELLS_X * CELLS_Y))
+RenderCache::RenderCache(Renderer& renderer) : renderer(renderer), screenRect{ 0, 0, 0, 0 }, rectBuffer(CELLS_X * CELLS_Y / 2),
+    changedBuffer(CELLS_X * CELLS_Y / 2),
+    cellsBuffer1(CELLS_X * CELLS_Y, HASH_INITIAL), cellsBuffer2(CELLS_X * CELLS_Y, HASH_INITIAL), overlayCells(CELLS_X * CELLS_Y, 0)
 {
     cellsPrevious = &cellsBuffer1;
     cells = &cellsBuffer2;
+    updateBuffer.reserve(rectBuffer.size());
+    commandBufferIdx = 0;
+    commandBufferPeak = 0;
+    showDebugInfo = false;
+    debugFont = nullptr;
+    frameStart = 0;
+    luaHeap = 0;
+    lastRectCount = 0;
+    lastDirtyPixels = 0;
 }
 
 RenderCache::~RenderCache()
@@ -71,11 +85,11 @@ void RenderCache::updateOverlappingCells(RenRect rect, uint32_t height)
     }
 }
 
-void RenderCache::pushRect(RenRect rect, int& count)
+void RenderCache::pushRect(std::vector<RenRect>& buffer, RenRect rect, int& count)
 {
     for (auto i = count - 1; i >= 0; i--)
     {
-        auto rectP = &rectBuffer[i];
+        auto rectP = &buffer[i];
         if(doRectsOverlap(*rectP, rect))
         {
             *rectP = mergeRects(*rectP, rect);
@@ -83,7 +97,21 @@ void RenderCache::pushRect(RenRect rect, int& count)
         }
     }
 
-    rectBuffer[count++] = rect;
+    buffer[count++] = rect;
+}
+
+void RenderCache::markOverlayCells(RenRect rect)
+{
+    rect = intersectRects(rect, screenRect);
+    if (rect.width == 0 || rect.height == 0) return;
+
+    for (int y = rect.y / CELL_SIZE; y <= (rect.y + rect.height - 1) / CELL_SIZE; y++)
+    {
+        for (int x = rect.x / CELL_SIZE; x <= (rect.x + rect.width - 1) / CELL_SIZE; x++)
+        {
+            overlayCells[cellIndex(x, y)] = 1;
+        }
+    }
 }
 
 Command* RenderCache::pushCommand(int type, int size)
@@ -106,7 +134,7 @@ bool RenderCache::nextCommand(Command** previous)
 {
     if (*previous == nullptr)
     {
-        *previous = reinterpret_cast<Command*>(commandBufferIdx);
+        *previous = reinterpret_cast<Command*>(commandBuffer);
     }
     else
     {
@@ -116,9 +144,42 @@ bool RenderCache::nextCommand(Command** previous)
     return *previous != reinterpret_cast<Command*>(commandBuffer + commandBufferIdx);
 }
 
-void RenderCache::showDebug(bool enable)
+void RenderCache::getFrameStats(int& rectCount, int64_t& dirtyPixels) const
+{
+    rectCount = lastRectCount;
+    dirtyPixels = lastDirtyPixels;
+}
+
+int RenderCache::getCommandBufferPeak() const
+{
+    return commandBufferPeak;
+}
+
+LatencyTracker& RenderCache::getLatency()
+{
+    return latency;
+}
+
+void RenderCache::showDebug(bool enable, RenFont* font)
 {
     showDebugInfo = enable;
+    debugFont = font;
+    debugRects.clear();
+}
+
+bool RenderCache::hasDebugRects() const
+{
+    return showDebugInfo && debugFont && !debugRects.empty();
+}
+
+void RenderCache::setLuaHeap(size_t bytes)
+{
+    luaHeap = bytes;
+}
+
+void RenderCache::setDebugText(const std::string& text)
+{
+    debugText = text;
 }
 
 void RenderCache::freeFont(RenFont* font)
@@ -144,8 +205,9 @@ int RenderCache::drawText(RenFont* font, std::string text, int x, int y, RenColo
 {
     auto len = text.length() + 1;
     auto command = pushCommand(DRAW_TEXT, text.length() + 1);
+    command->text = reinterpret_cast<char*>(command + 1);
     memcpy(command->text, text.c_str(), len - 1);
-    command->text[len] = '\0'; // just to make sure
+    command->text[len - 1] = '\0'; // just to make sure
     command->font = font;
     command->rect.x = x;
     command->rect.y = y;
@@ -158,8 +220,9 @@ void RenderCache::beginFrame()
 {
     int width, height;
     renderer.getSize(width, height);
+    frameStart = SDL_GetPerformanceCounter() / (double)SDL_GetPerformanceFrequency();
 
-    if (screenRect.width != 0 || height != screenRect.height)
+    if (width != screenRect.width || height != screenRect.height)
     {
         screenRect.width = width;
         screenRect.height = height;
@@ -169,11 +232,15 @@ void RenderCache::beginFrame()
 
 void RenderCache::endFrame()
 {
+    ProfileZone zone("RenderCache::endFrame");
+    auto endFrameStart = SDL_GetPerformanceCounter() / (double)SDL_GetPerformanceFrequency();
     Command* command = nullptr;
     auto clipRect = screenRect;
+    auto commandCount = 0;
 
     while (nextCommand(&command))
     {
+        commandCount++;
         if (command->type == SET_CLIP) clipRect = command->rect;
 
         auto rect = intersectRects(command->rect, clipRect);
@@ -184,7 +251,10 @@ void RenderCache::endFrame()
         updateOverlappingCells(rect, hsh);
     }
 
-    auto rectCount = 0;
+    // cells only repainted to remove last frame's overlay are left out of
+    // `changed`, so the overlay does not outline its own traces
+    auto& changed = changedBuffer;
+    auto rectCount = 0, changedCount = 0;
     auto maxX = screenRect.width / CELL_SIZE + 1;
     auto maxY = screenRect.height / CELL_SIZE + 1;
     for (auto y = 0; y < maxY; y++)
@@ -192,18 +262,24 @@ void RenderCache::endFrame()
         for (auto x = 0; x < maxX; x++)
         {
             auto idx = cellIndex(x, y);
-            if (cells[idx] != cellsPrevious[idx])
+            bool differs = (*cells)[idx] != (*cellsPrevious)[idx];
+            if (differs || overlayCells[idx])
+            {
+                pushRect(rectBuffer, RenRect{ x, y, 1, 1 }, rectCount);
+            }
+            if (differs && showDebugInfo)
             {
-                pushRect(RenRect{ x, y, 1, 1 }, rectCount);
+                pushRect(changed, RenRect{ x, y, 1, 1 }, changedCount);
             }
 
             (*cellsPrevious)[idx] = HASH_INITIAL;
+            overlayCells[idx] = 0;
         }
     }
 
-    for (auto i = 0; i < rectCount; i++)
+    for (auto i = 0; i < rectCount + changedCount; i++)
     {
-        auto rect = &rectBuffer[i];
+        auto rect = i < rectCount ? &rectBuffer[i] : &changed[i - rectCount];
         rect->x *= CELL_SIZE, rect->y *= CELL_SIZE;
         rect->width*= CELL_SIZE, rect->height *= CELL_SIZE;
         *rect = intersectRects(*rect, screenRect);
@@ -234,19 +310,33 @@ void RenderCache::endFrame()
                 renderer.DrawText(command->font, command->text, command->rect.x, command->rect.y, command->color);
                 break;
             }
+        }
+    }
 
-            if (showDebugInfo)
-            {
-                // not needed for now
-                // renderer.DrawRect(rect, RenColor{ (char)rand(), (char)rand(), (char)rand(), 50 });
-            }
+    lastRectCount = rectCount;
+    lastDirtyPixels = 0;
+    for (auto i = 0; i < rectCount; i++)
+    {
+        lastDirtyPixels += (int64_t)rectBuffer[i].width * rectBuffer[i].height;
+    }
+
+    auto& updates = updateBuffer;
+    updates.assign(rectBuffer.begin(), rectBuffer.begin() + rectCount);
+    if (showDebugInfo && debugFont)
+    {
+        for (auto i = 0; i < changedCount; i++)
+        {
+            debugRects.push_back(DebugRect{ changed[i], -1 });
         }
+        auto now = SDL_GetPerformanceCounter() / (double)SDL_GetPerformanceFrequency();
+        drawDebugOverlay(updates, commandCount, now - frameStart, now - endFrameStart);
     }
 
-    if (rectCount > 0)
+    if (!updates.empty())
     {
-        renderer.updateRects(rectBuffer);
+        renderer.updateRects(updates);
     }
+    latency.frame(rectCount > 0, SDL_GetPerformanceCounter() / (double)SDL_GetPerformanceFrequency());
 
     if (freeCommands)
     {
@@ -255,6 +345,7 @@ void RenderCache::endFrame()
         {
             if (command->type == FREE_FONT)
             {
+                if (command->font == debugFont) debugFont = nullptr;
                 renderer.freeFont(command->font);
             }
         }
@@ -263,10 +354,70 @@ void RenderCache::endFrame()
     auto temp = cells;
     cells = cellsPrevious;
     cellsPrevious = temp;
+    commandBufferPeak = max(commandBufferPeak, commandBufferIdx);
     commandBufferIdx = 0;
 }
 
+void RenderCache::drawDebugOverlay(std::vector<RenRect>& updates, int commandCount, double frameTime, double endFrameTime)
+{
+    renderer.setClipRect(screenRect);
+
+    // outline what was repainted, fading out over DEBUG_RECT_FRAMES frames
+    auto expired = [](DebugRect& debugRect) { return ++debugRect.age >= DEBUG_RECT_FRAMES; };
+    debugRects.erase(std::remove_if(debugRects.begin(), debugRects.end(), expired), debugRects.end());
+    for (auto& debugRect : debugRects)
+    {
+        auto rect = debugRect.rect;
+        auto alpha = static_cast<uint8_t>(255 - debugRect.age * 200 / DEBUG_RECT_FRAMES);
+        RenColor color{ 0, 0, 255, alpha };
+        RenRect edges[] =
+        {
+            { rect.x, rect.y, rect.width, 1 },
+            { rect.x, rect.y + rect.height - 1, rect.width, 1 },
+            { rect.x, rect.y, 1, rect.height },
+            { rect.x + rect.width - 1, rect.y, 1, rect.height },
+        };
+        for (auto& edge : edges)
+        {
+            edge = intersectRects(edge, screenRect);
+            if (edge.width == 0 || edge.height == 0) continue;
+            renderer.DrawRect(edge, color);
+            markOverlayCells(edge);
+            updates.push_back(edge);
+        }
+    }
+
+    int glyphSets;
+    size_t glyphBytes;
+    renderer.getGlyphCacheSize(glyphSets, glyphBytes);
+    auto screenPixels = (double)screenRect.width * screenRect.height;
+
+    char lines[6][64];
+    snprintf(lines[0], sizeof(lines[0]), "frame %.2f ms  end_frame %.2f ms", frameTime * 1000, endFrameTime * 1000);
+    snprintf(lines[1], sizeof(lines[1]), "commands %d  %.1f KB", commandCount, commandBufferIdx / 1024.0);
+    snprintf(lines[2], sizeof(lines[2]), "dirty %.1f%%  %d rects", screenPixels > 0 ? lastDirtyPixels * 100 / screenPixels : 0.0, lastRectCount);
+    snprintf(lines[3], sizeof(lines[3]), "glyph sets %d  %.1f KB", glyphSets, glyphBytes / 1024.0);
+    snprintf(lines[4], sizeof(lines[4]), "lua heap %.1f KB", luaHeap / 1024.0);
+    snprintf(lines[5], sizeof(lines[5]), "%s", debugText.c_str());
+    auto lineCount = debugText.empty() ? 5 : 6;
+
+    const int padding = 4;
+    auto lineHeight = renderer.getFontHeight(debugFont);
+    auto width = 0;
+    for (auto i = 0; i < lineCount; i++) width = max(width, renderer.getFontWidth(debugFont, lines[i]));
+
+    RenRect box{ 0, 0, width + padding * 2, lineHeight * lineCount + padding * 2 };
+    box.x = screenRect.width - box.width;
+    renderer.DrawRect(box, RenColor{ 0, 0, 0, 200 });
+    for (auto i = 0; i < lineCount; i++)
+    {
+        renderer.DrawText(debugFont, lines[i], box.x + padding, box.y + padding + i * lineHeight, RenColor{ 255, 255, 255, 255 });
+    }
+    markOverlayCells(box);
+    updates.push_back(intersectRects(box, screenRect));
+}
+
 void RenderCache::InvalidateCache()
 {
-    memset(cellsPrevious, 0xff, sizeof(cellsBuffer1));
+    std::fill(cellsPrevious->begin(), cellsPrevious->end(), 0xffffffff);
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "LatencyTracker.h"
 #include "Renderer.h"
 
 #define CELLS_X 80
@@ -7,6 +8,9 @@
 #define CELL_SIZE 96
 #define COMMAND_BUF_SIZE (1024 * 512)
 
+// frames a repainted rect stays outlined by the debug overlay
+#define DEBUG_RECT_FRAMES 8
+
 typedef struct {
 	int type, size;
 	RenRect rect;
@@ -21,9 +25,14 @@ private:
 	Renderer& renderer;
 	RenRect screenRect;
 
-	std::vector<RenRect>& rectBuffer;
-	std::vector<uint32_t>& cellsBuffer1;
-	std::vector<uint32_t>& cellsBuffer2;
+	std::vector<RenRect> rectBuffer;
+
+	// the rects sent to the window, and the cells which really changed for
+	// the debug overlay; kept so end_frame does not allocate
+	std::vector<RenRect> updateBuffer;
+	std::vector<RenRect> changedBuffer;
+	std::vector<uint32_t> cellsBuffer1;
+	std::vector<uint32_t> cellsBuffer2;
 
 	// 
 	std::vector<uint32_t>* cellsPrevious;
@@ -31,10 +40,28 @@ private:
 
 	char commandBuffer[COMMAND_BUF_SIZE];
 	int commandBufferIdx;
+	int commandBufferPeak;
 	bool showDebugInfo;
+	LatencyTracker latency;
+
+	// debug overlay: the font of its text, the recently repainted rects,
+	// the cells it drew over (repainted next frame) and what it shows
+	struct DebugRect { RenRect rect; int age; };
+	RenFont* debugFont;
+	std::vector<DebugRect> debugRects;
+	std::vector<uint8_t> overlayCells;
+	double frameStart;
+	size_t luaHeap;
+	std::string debugText;
+
+	// what the last frame sent to the window
+	int lastRectCount;
+	int64_t lastDirtyPixels;
 
 	void updateOverlappingCells(RenRect rect, uint32_t height);
-	void pushRect(RenRect rect, int& count);
+	void pushRect(std::vector<RenRect>& buffer, RenRect rect, int& count);
+	void markOverlayCells(RenRect rect);
+	void drawDebugOverlay(std::vector<RenRect>& updates, int commandCount, double frameTime, double endFrameTime);
 
 	Command* pushCommand(int type, int size = 0);
 	bool nextCommand(Command** previous);
@@ -43,7 +70,15 @@ public:
 	RenderCache(Renderer& renderer);
 	~RenderCache();
 
-	void showDebug(bool enable);
+	LatencyTracker& getLatency();
+	void getFrameStats(int& rectCount, int64_t& dirtyPixels) const;
+	int getCommandBufferPeak() const;
+	void showDebug(bool enable, RenFont* font);
+	// true while the debug overlay has outlines left to fade, which only
+	// happens as frames are drawn
+	bool hasDebugRects() const;
+	void setLuaHeap(size_t bytes);
+	void setDebugText(const std::string& text);
 	void freeFont(RenFont* font);
 	void setClipRect(RenRect rect);
 	void drawRect(RenRect rect, RenColor color);
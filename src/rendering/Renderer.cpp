@@ -1,9 +1,11 @@
 #include <stdio.h>
 #include <assert.h>
+#include <algorithm>
 #include <fstream>
 #include <math.h>
 
 #include "Renderer.h"
+#include "../profiler/Profiler.h"
 
 
 #pragma region PIXEL BLENDING
@@ -28,14 +30,25 @@ static inline RenColor blend_pixel2(RenColor dst, RenColor src, RenColor color)
 #pragma endregion
 
 #pragma region RENDERER CONSTRUCTOR
-Renderer::Renderer(SDL_Window* window) : window(window)
+Renderer::Renderer(SDL_Window* window) : window(window), surface(nullptr), glyphSets(0), glyphBytes(0)
 {
     assert(window);
 
-    auto surf = SDL_GetWindowSurface(window);
+    auto surf = getSurface();
     setClipRect(RenRect { 0, 0, surf->w, surf->h });
 }
 
+Renderer::Renderer(SDL_Surface* surface) : window(nullptr), surface(surface), glyphSets(0), glyphBytes(0)
+{
+    assert(surface);
+    setClipRect(RenRect { 0, 0, surface->w, surface->h });
+}
+
+SDL_Surface* Renderer::getSurface()
+{
+    return window ? SDL_GetWindowSurface(window) : surface;
+}
+
 Renderer::~Renderer() { }
 #pragma endregion
 
@@ -79,12 +92,14 @@ retry:
         set->image->pixels[i] = RenColor{ 255, 255, 255, n };
     }
 
+    glyphSets++;
+    glyphBytes += sizeof(RenColor) * width * height;
     return set;
 }
 
 GlyphSet* Renderer::getGlyphset(RenFont* font, int codePoint)
 {
-    auto idx = (codePoint >> 8) & MAX_GLYPHSET;
+    auto idx = (codePoint >> 8) % MAX_GLYPHSET;
     if (!font->sets[idx])
     {
         font->sets[idx] = loadGlyphset(font, idx);
@@ -95,8 +110,10 @@ GlyphSet* Renderer::getGlyphset(RenFont* font, int codePoint)
 #pragma endregion
 
 #pragma region RENDER RECTS
-void Renderer::updateRects(std::vector<RenRect> rects)
+void Renderer::updateRects(const std::vector<RenRect>& rects)
 {
+    ProfileZone zone("Renderer::updateRects");
+    if (!window) return;
     SDL_UpdateWindowSurfaceRects(window, reinterpret_cast<const SDL_Rect*>(&rects[0]), rects.size());
 }
 
@@ -105,12 +122,12 @@ void Renderer::setClipRect(RenRect rect)
     clip.left = rect.x;
     clip.top = rect.y;
     clip.right = rect.x + rect.width;
-    clip.bottom = rect.y + rect.width;
+    clip.bottom = rect.y + rect.height;
 }
 
 void Renderer::getSize(int& x, int& y)
 {
-    auto surf = SDL_GetWindowSurface(window);
+    auto surf = getSurface();
     x = surf->w, y = surf->h;
 }
 #pragma endregion
@@ -123,6 +140,7 @@ RenImage* Renderer::newImage(int width, int height)
     auto image = new RenImage();
     assert(image);
 
+    image->pixels = new RenColor[width * height];
     image->height = height;
     image->width = width;
     return image;
@@ -131,6 +149,7 @@ RenImage* Renderer::newImage(int width, int height)
 void Renderer::freeImage(RenImage* image)
 {
     assert(image);
+    delete[] image->pixels;
     delete image;
 }
 #pragma endregion
@@ -158,6 +177,7 @@ RenFont* Renderer::loadFont(const std::string& fileName, float size)
     RenFont* font = new RenFont();
     assert(font);
 
+    font->fileName = fileName;
     font->size = size;
 
     // load the font into the buffer
@@ -173,6 +193,7 @@ RenFont* Renderer::loadFont(const std::string& fileName, float size)
     file.seekg(0, std::ios::end);
     fileSize = file.tellg() - fileSize;
     file.seekg(0, std::ios::beg);
+    font->dataSize = static_cast<size_t>(fileSize);
     font->data = new char[fileSize];
     file.read(reinterpret_cast<char*>(font->data), fileSize);
     file.close();
@@ -183,6 +204,7 @@ RenFont* Renderer::loadFont(const std::string& fileName, float size)
     {
         delete[] font->data;
         delete font;
+        return nullptr;
     }
 
 
@@ -197,6 +219,7 @@ RenFont* Renderer::loadFont(const std::string& fileName, float size)
     glyphs['\t'].x1 = glyphs['\t'].x0;
     glyphs['\n'].x1 = glyphs['\n'].x0;
 
+    fonts.push_back(font);
     return font;
 }
 
@@ -207,11 +230,14 @@ void Renderer::freeFont(RenFont* font)
         auto set = font->sets[i];
         if (set)
         {
+            glyphSets--;
+            glyphBytes -= sizeof(RenColor) * set->image->width * set->image->height;
             freeImage(set->image);
             delete set;
         }
     }
 
+    fonts.erase(std::remove(fonts.begin(), fonts.end(), font), fonts.end());
     delete[] font->data;
     delete font;
 }
@@ -241,6 +267,33 @@ int Renderer::getFontHeight(RenFont* font)
 {
     return font->height;
 }
+
+void Renderer::getGlyphCacheSize(int& sets, size_t& bytes)
+{
+    sets = glyphSets;
+    bytes = glyphBytes;
+}
+
+const std::vector<RenFont*>& Renderer::getFonts()
+{
+    return fonts;
+}
+
+size_t Renderer::getFontGlyphBytes(RenFont* font)
+{
+    size_t bytes = 0;
+    for (auto set : font->sets)
+    {
+        if (set) bytes += sizeof(RenColor) * set->image->width * set->image->height;
+    }
+    return bytes;
+}
+
+size_t Renderer::getSurfaceBytes()
+{
+    auto surf = getSurface();
+    return static_cast<size_t>(surf->pitch) * surf->h;
+}
 #pragma endregion
 
 #pragma region RENDER DRAWING
@@ -260,6 +313,7 @@ int Renderer::getFontHeight(RenFont* font)
 
 void Renderer::DrawRect(RenRect rect, RenColor color)
 {
+    ProfileZone zone("Renderer::DrawRect");
     if (color.a == 0) return;
     
     int x1 = rect.x < clip.left ? clip.left : rect.x,
@@ -270,7 +324,7 @@ void Renderer::DrawRect(RenRect rect, RenColor color)
     x2 = x2 > clip.right ? clip.right : x2;
     y2 = y2 > clip.bottom ? clip.bottom : y2;
 
-    auto surface = SDL_GetWindowSurface(window);
+    auto surface = getSurface();
     auto pixels = reinterpret_cast<RenColor*>(surface->pixels);
 
     pixels += x1 + y1 * surface->w;
@@ -300,7 +354,7 @@ void Renderer::DrawImage(RenImage* image, RenRect* sub, int x, int y, RenColor c
     if (sub->width <= 0 || sub->height <= 0) return;
 
     // draw image
-    auto surf = SDL_GetWindowSurface(window);
+    auto surf = getSurface();
     auto imgPixels = image->pixels;
     auto srfPixels = reinterpret_cast<RenColor*>(surf->pixels);
 
@@ -324,6 +378,7 @@ void Renderer::DrawImage(RenImage* image, RenRect* sub, int x, int y, RenColor c
 
 int Renderer::DrawText(RenFont* font, std::string text, int x, int y, RenColor color)
 {
+    ProfileZone zone("Renderer::DrawText");
     RenRect rect;
     const char* p = text.c_str();
     unsigned codePoint;
@@ -31,7 +31,9 @@ struct GlyphSet {
 };
 
 struct RenFont {
+	std::string fileName;
 	void* data;
+	size_t dataSize;
 	stbtt_fontinfo stbfont;
 	GlyphSet* sets[MAX_GLYPHSET];
 	float size;
@@ -43,17 +45,30 @@ class Renderer
 {
 private:
 	SDL_Window* window;
+
+	// drawn to instead of a window's surface when there is no window
+	SDL_Surface* surface;
 	struct { int left, top, right, bottom; } clip;
 
+	// glyph sets baked for all fonts and the bytes of their images
+	int glyphSets;
+	size_t glyphBytes;
+
+	// every font loaded and not freed yet
+	std::vector<RenFont*> fonts;
+
+	SDL_Surface* getSurface();
+
 	GlyphSet* loadGlyphset(RenFont* font, int idx);
 	GlyphSet* getGlyphset(RenFont* font, int codePoint);
 
 public:
 	Renderer(SDL_Window* window);
+	Renderer(SDL_Surface* surface);
 	~Renderer();
 
 	// rects stuff
-	void updateRects(std::vector<RenRect> rects);
+	void updateRects(const std::vector<RenRect>& rects);
 	void setClipRect(RenRect rect);
 	void getSize(int& x, int& y);
 
@@ -67,6 +82,10 @@ public:
 	void setFontTabWidth(RenFont* font, int width);
 	int getFontWidth(RenFont* font, std::string text);
 	int getFontHeight(RenFont* font);
+	void getGlyphCacheSize(int& sets, size_t& bytes);
+	const std::vector<RenFont*>& getFonts();
+	size_t getFontGlyphBytes(RenFont* font);
+	size_t getSurfaceBytes();
 
 	// actual rendering
 	void DrawRect(RenRect rect, RenColor color);
@@ -0,0 +1,157 @@
+#include "Scheduler.h"
+
+#include <algorithm>
+#include <math.h>
+#include <SDL.h>
+
+
+Scheduler::Scheduler() : sleeping(0), frameEnd(0), handedOut(false)
+{
+    currentTick = getTick(now());
+}
+
+double Scheduler::now()
+{
+    return SDL_GetPerformanceCounter() / static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+uint64_t Scheduler::getTick(double time) const
+{
+    return static_cast<uint64_t>(time / SCHEDULER_TICK);
+}
+
+void Scheduler::add(uint32_t id, int priority)
+{
+    Entry entry;
+    entry.priority = std::clamp(priority, 0, SCHEDULER_PRIORITIES - 1);
+    auto it = entries.find(id);
+    entry.generation = it == entries.end() ? 0 : it->second.generation + 1;
+    entries[id] = entry;
+    push(id, entry);
+}
+
+void Scheduler::remove(uint32_t id)
+{
+    // queued copies are skipped once the entry is gone
+    entries.erase(id);
+}
+
+void Scheduler::push(uint32_t id, const Entry& entry)
+{
+    ready[entry.priority].emplace_back(id, entry.generation);
+}
+
+void Scheduler::wake(uint32_t id)
+{
+    auto it = entries.find(id);
+    if (it == entries.end()) return;
+    it->second.generation++;
+    push(id, it->second);
+}
+
+void Scheduler::sleep(uint32_t id, double seconds)
+{
+    auto it = entries.find(id);
+    if (it == entries.end()) return;
+    it->second.generation++;
+
+    // an endless sleep only invalidates queued copies; `wake` resumes it
+    if (!isfinite(seconds)) return;
+
+    // due ticks are visited from the slot after the current one
+    auto tick = std::max(getTick(now() + seconds) + 1, currentTick + 1);
+    slots[tick % SCHEDULER_SLOTS].push_back({ id, it->second.generation, tick });
+    sleeping++;
+}
+
+void Scheduler::advance(uint64_t tick)
+{
+    if (tick <= currentTick) return;
+
+    // after a long pause every slot is visited once rather than every tick
+    auto count = std::min<uint64_t>(tick - currentTick, SCHEDULER_SLOTS);
+    for (uint64_t i = 1; i <= count && sleeping > 0; i++)
+    {
+        auto& slot = slots[(currentTick + i) % SCHEDULER_SLOTS];
+        for (size_t j = 0; j < slot.size(); )
+        {
+            auto& timer = slot[j];
+            if (timer.tick > tick)
+            {
+                j++;
+                continue;
+            }
+
+            auto it = entries.find(timer.id);
+            if (it != entries.end() && it->second.generation == timer.generation) push(timer.id, it->second);
+            slot[j] = slot.back();
+            slot.pop_back();
+            sleeping--;
+        }
+    }
+    currentTick = tick;
+}
+
+void Scheduler::beginFrame(double budget)
+{
+    auto time = now();
+    advance(getTick(time));
+    frameEnd = time + budget;
+    handedOut = false;
+}
+
+bool Scheduler::next(uint32_t& id)
+{
+    for (auto& queue : ready)
+    {
+        while (!queue.empty())
+        {
+            auto [queuedId, generation] = queue.front();
+            auto it = entries.find(queuedId);
+            if (it == entries.end() || it->second.generation != generation)
+            {
+                queue.pop_front();
+                continue;
+            }
+
+            // only checked when there is something to run
+            if (handedOut && now() >= frameEnd) return false;
+            queue.pop_front();
+            id = queuedId;
+            handedOut = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Scheduler::hasReady() const
+{
+    for (auto& queue : ready)
+    {
+        for (auto& [id, generation] : queue)
+        {
+            auto it = entries.find(id);
+            if (it != entries.end() && it->second.generation == generation) return true;
+        }
+    }
+    return false;
+}
+
+double Scheduler::getTimeUntilWake() const
+{
+    if (sleeping == 0) return -1;
+
+    uint64_t earliest = UINT64_MAX;
+    for (auto& slot : slots)
+    {
+        for (auto& timer : slot)
+        {
+            auto it = entries.find(timer.id);
+            if (it != entries.end() && it->second.generation == timer.generation)
+                earliest = std::min(earliest, timer.tick);
+        }
+    }
+    if (earliest == UINT64_MAX) return -1;
+    return std::max(0.0, earliest * SCHEDULER_TICK - now());
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+// ticks of the timer wheel; a sleep is rounded up to whole ticks
+#define SCHEDULER_TICK 0.005
+#define SCHEDULER_SLOTS 512
+#define SCHEDULER_PRIORITIES 4
+
+// Decides which Lua threads run each frame. Ready threads wait in one
+// queue per priority and run highest priority first, round robin within
+// a priority, until the frame budget is spent. Sleeping threads wait in a
+// hashed timer wheel and are only looked at again when their slot comes
+// up, so a frame without due threads costs next to nothing.
+class Scheduler
+{
+private:
+    struct Entry
+    {
+        int priority;
+        uint32_t generation;
+    };
+
+    struct Timer
+    {
+        uint32_t id;
+        uint32_t generation;
+        uint64_t tick;
+    };
+
+    std::unordered_map<uint32_t, Entry> entries;
+    std::deque<std::pair<uint32_t, uint32_t>> ready[SCHEDULER_PRIORITIES];
+    std::vector<Timer> slots[SCHEDULER_SLOTS];
+    size_t sleeping;
+    uint64_t currentTick;
+    double frameEnd;
+    bool handedOut;
+
+    static double now();
+    uint64_t getTick(double time) const;
+    void push(uint32_t id, const Entry& entry);
+    void advance(uint64_t tick);
+
+public:
+    Scheduler();
+
+    // priority 0 runs first
+    void add(uint32_t id, int priority);
+    void remove(uint32_t id);
+
+    // queues a thread to run again, behind others of its priority
+    void wake(uint32_t id);
+
+    // an infinite `seconds` suspends the thread until it is woken
+    void sleep(uint32_t id, double seconds);
+
+    // moves due sleepers to the ready queues and starts the budget
+    void beginFrame(double budget);
+
+    // returns false once nothing is ready or the budget is spent; the
+    // first ready thread of a frame always runs, so an overrun frame still
+    // makes progress
+    bool next(uint32_t& id);
+
+    bool hasReady() const;
+
+    // seconds until the earliest sleeper is due, or -1 if none sleep
+    double getTimeUntilWake() const;
+};
@@ -0,0 +1,22 @@
+#include "Wakeup.h"
+
+#include <SDL.h>
+
+uint32_t Wakeup::eventType = 0;
+
+
+uint32_t Wakeup::getEventType()
+{
+    if (eventType == 0) eventType = SDL_RegisterEvents(1);
+    return eventType;
+}
+
+void Wakeup::post()
+{
+    if (eventType == 0 || eventType == (uint32_t)-1) return;
+
+    SDL_Event e;
+    SDL_zero(e);
+    e.type = eventType;
+    SDL_PushEvent(&e);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+
+// Wakes the main loop while it blocks waiting for events. Background
+// threads whose results are polled from Lua post a wakeup once a result is
+// ready, so the main loop never has to poll them on a timer. The event
+// carries nothing and is dropped by `system.poll_event`.
+class Wakeup
+{
+private:
+    static uint32_t eventType;
+
+public:
+    // registers the event type; call once from the main thread before any
+    // background thread can post
+    static uint32_t getEventType();
+
+    static void post();
+};
@@ -0,0 +1,261 @@
+#include "FuzzyMatcher.h"
+
+#include <ctype.h>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+
+#pragma region HELPER FUNCTIONS
+static inline bool isBetter(const FuzzyMatch& a, const FuzzyMatch& b)
+{
+    return a.score > b.score || (a.score == b.score && a.index < b.index);
+}
+
+// keeps the best `limit` matches in a heap with the worst match on top
+static void pushMatch(std::vector<FuzzyMatch>& heap, FuzzyMatch match, size_t limit)
+{
+    if (limit == 0)
+    {
+        heap.push_back(match);
+        return;
+    }
+
+    if (heap.size() < limit)
+    {
+        heap.push_back(match);
+        std::push_heap(heap.begin(), heap.end(), isBetter);
+    }
+    else if (isBetter(match, heap.front()))
+    {
+        std::pop_heap(heap.begin(), heap.end(), isBetter);
+        heap.back() = match;
+        std::push_heap(heap.begin(), heap.end(), isBetter);
+    }
+}
+
+#pragma endregion
+
+
+#pragma region THREAD POOL
+// Helper threads kept for the life of the program, so scoring a large list
+// on every keystroke does not create and join threads each time. The
+// calling thread scores slice 0 itself while the helpers take the others.
+class MatchPool
+{
+private:
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::vector<std::thread> threads;
+    const std::function<void(size_t)>* task;
+    uint64_t generation;
+    size_t pending;
+    bool stopping;
+
+    // held by the thread whose task the helpers are running
+    std::mutex owner;
+
+    void work(size_t slice)
+    {
+        uint64_t seen = 0;
+        while (true)
+        {
+            const std::function<void(size_t)>* current;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+                current = task;
+            }
+
+            (*current)(slice);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) done.notify_one();
+        }
+    }
+
+public:
+    MatchPool(size_t sliceCount) : task(nullptr), generation(0), pending(0), stopping(false)
+    {
+        for (size_t slice = 1; slice < sliceCount; slice++)
+        {
+            threads.emplace_back(&MatchPool::work, this, slice);
+        }
+    }
+
+    ~MatchPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& thread : threads) thread.join();
+    }
+
+    static MatchPool& get()
+    {
+        static MatchPool instance(std::max(1u, std::thread::hardware_concurrency()));
+        return instance;
+    }
+
+    size_t getSliceCount() const
+    {
+        return threads.size() + 1;
+    }
+
+    // calls `fn` with every slice number and returns once all are done;
+    // returns false without calling it if another thread is using the pool
+    bool run(const std::function<void(size_t)>& fn)
+    {
+        std::unique_lock<std::mutex> running(owner, std::try_to_lock);
+        if (!running.owns_lock()) return false;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task = &fn;
+            pending = threads.size();
+            generation++;
+        }
+        wake.notify_all();
+
+        fn(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pending == 0; });
+        return true;
+    }
+};
+
+// the pool is only started by the first list large enough to need it
+static size_t getThreadCount(size_t count)
+{
+    if (count < FUZZY_PARALLEL_THRESHOLD) return 1;
+    return MatchPool::get().getSliceCount();
+}
+#pragma endregion
+
+
+void FuzzyMatcher::parallelFor(size_t count, const std::function<void(size_t, size_t, size_t)>& fn)
+{
+    auto threadCount = getThreadCount(count);
+    if (threadCount == 1)
+    {
+        fn(0, count, 0);
+        return;
+    }
+
+    auto chunk = (count + threadCount - 1) / threadCount;
+    auto slice = [&](size_t t)
+    {
+        auto first = std::min(count, t * chunk);
+        auto last = std::min(count, first + chunk);
+        fn(first, last, t);
+    };
+
+    // another thread is matching with the pool; score every slice here
+    if (!MatchPool::get().run(slice))
+    {
+        for (size_t t = 0; t < threadCount; t++) slice(t);
+    }
+}
+
+bool FuzzyMatcher::score(std::string_view str, std::string_view needle, int& score)
+{
+    auto s = str.begin(), se = str.end();
+    auto p = needle.begin(), pe = needle.end();
+    int run = 0;
+    score = 0;
+
+    while (s != se && p != pe)
+    {
+        while (s != se && *s == ' ') s++;
+        while (p != pe && *p == ' ') p++;
+        if (s == se || p == pe) break;
+
+        if (tolower(*s) == tolower(*p))
+        {
+            score += run * 10 - (*s != *p);
+            run++;
+            p++;
+        }
+        else
+        {
+            score -= 10;
+            run = 0;
+        }
+        s++;
+    }
+
+    while (p != pe && *p == ' ') p++;
+    if (p != pe) return false;
+
+    score -= static_cast<int>(se - s);
+    return true;
+}
+
+std::vector<FuzzyMatch> FuzzyMatcher::matchList(const std::vector<std::string_view>& items,
+    std::string_view needle, size_t limit)
+{
+    // each thread keeps its own top `limit` heap over a slice of the items;
+    // the slices are merged afterwards
+    std::vector<std::vector<FuzzyMatch>> partial(getThreadCount(items.size()));
+    parallelFor(items.size(), [&](size_t first, size_t last, size_t slice)
+    {
+        int value;
+        for (auto i = first; i < last; i++)
+        {
+            if (score(items[i], needle, value))
+            {
+                pushMatch(partial[slice], FuzzyMatch{ static_cast<uint32_t>(i), value }, limit);
+            }
+        }
+    });
+
+    std::vector<FuzzyMatch> res;
+    for (auto& matches : partial)
+    {
+        for (auto& match : matches) pushMatch(res, match, limit);
+    }
+
+    std::sort(res.begin(), res.end(), isBetter);
+    return res;
+}
+
+std::vector<FuzzyMatch> FuzzyMatcher::filterList(const std::vector<std::string_view>& items,
+    const std::vector<FuzzyMatch>& candidates, std::string_view needle)
+{
+    std::vector<std::vector<FuzzyMatch>> partial(getThreadCount(candidates.size()));
+    parallelFor(candidates.size(), [&](size_t first, size_t last, size_t slice)
+    {
+        int value;
+        for (auto i = first; i < last; i++)
+        {
+            auto index = candidates[i].index;
+            if (score(items[index], needle, value))
+            {
+                partial[slice].push_back(FuzzyMatch{ index, value });
+            }
+        }
+    });
+
+    // slices are in candidate order, so concatenating keeps that order
+    std::vector<FuzzyMatch> res;
+    for (auto& matches : partial)
+    {
+        res.insert(res.end(), matches.begin(), matches.end());
+    }
+    return res;
+}
+
+std::vector<FuzzyMatch> FuzzyMatcher::selectBest(const std::vector<FuzzyMatch>& matches, size_t limit)
+{
+    std::vector<FuzzyMatch> res;
+    for (auto& match : matches) pushMatch(res, match, limit);
+    std::sort(res.begin(), res.end(), isBetter);
+    return res;
+}
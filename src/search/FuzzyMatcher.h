@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+// below this many items a list is scored on the calling thread
+#define FUZZY_PARALLEL_THRESHOLD 4096
+
+struct FuzzyMatch
+{
+    uint32_t index;
+    int score;
+};
+
+class FuzzyMatcher
+{
+private:
+    static void parallelFor(size_t count, const std::function<void(size_t, size_t, size_t)>& fn);
+
+public:
+    // returns false if `needle` is not a subsequence of `str`
+    static bool score(std::string_view str, std::string_view needle, int& score);
+
+    // scores every item and returns the best `limit` matches (all matches if
+    // `limit` is 0), ordered from best to worst
+    static std::vector<FuzzyMatch> matchList(const std::vector<std::string_view>& items,
+        std::string_view needle, size_t limit);
+
+    // rescores only the `candidates` against `needle`, returning every
+    // surviving candidate in its original order
+    static std::vector<FuzzyMatch> filterList(const std::vector<std::string_view>& items,
+        const std::vector<FuzzyMatch>& candidates, std::string_view needle);
+
+    // returns the best `limit` of `matches` (all if `limit` is 0), ordered
+    // from best to worst
+    static std::vector<FuzzyMatch> selectBest(const std::vector<FuzzyMatch>& matches, size_t limit);
+};
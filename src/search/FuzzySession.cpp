@@ -0,0 +1,69 @@
+#include "FuzzySession.h"
+
+
+FuzzySession::FuzzySession(const std::vector<std::string_view>& source)
+{
+    size_t total = 0;
+    for (auto& item : source) total += item.size();
+
+    // copy every item into one buffer so the session does not depend on the
+    // lifetime of the strings it was created from
+    std::vector<size_t> offsets;
+    offsets.reserve(source.size());
+    storage.reserve(total);
+    for (auto& item : source)
+    {
+        offsets.push_back(storage.size());
+        storage.append(item);
+    }
+
+    items.reserve(source.size());
+    for (size_t i = 0; i < source.size(); i++)
+    {
+        items.emplace_back(storage.data() + offsets[i], source[i].size());
+    }
+}
+
+bool FuzzySession::isPrefix(const std::string& prefix, std::string_view query)
+{
+    return prefix.size() <= query.size() && query.compare(0, prefix.size(), prefix) == 0;
+}
+
+std::vector<FuzzyMatch> FuzzySession::filter(std::string_view query, size_t limit, size_t& total)
+{
+    // drop cached levels which are not a prefix of the new query
+    while (!levels.empty() && !isPrefix(levels.back().query, query))
+    {
+        levels.pop_back();
+    }
+
+    if (levels.empty() || levels.back().query.size() != query.size())
+    {
+        Level level;
+        level.query = std::string(query);
+        if (levels.empty())
+        {
+            level.matches = FuzzyMatcher::matchList(items, query, 0);
+        }
+        else
+        {
+            // anything which failed the shorter query fails this one too
+            level.matches = FuzzyMatcher::filterList(items, levels.back().matches, query);
+        }
+        levels.push_back(std::move(level));
+    }
+
+    auto& matches = levels.back().matches;
+    total = matches.size();
+    return FuzzyMatcher::selectBest(matches, limit);
+}
+
+size_t FuzzySession::size() const
+{
+    return items.size();
+}
+
+std::string_view FuzzySession::getItem(size_t idx) const
+{
+    return items[idx];
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "FuzzyMatcher.h"
+
+// Keeps the surviving candidates for each query prefix typed so far.
+// Extending the query only rescores the survivors of the longest cached
+// prefix; shortening it falls back to an already cached level.
+class FuzzySession
+{
+private:
+    struct Level
+    {
+        std::string query;
+        std::vector<FuzzyMatch> matches;
+    };
+
+    std::string storage;
+    std::vector<std::string_view> items;
+    std::vector<Level> levels;
+
+    static bool isPrefix(const std::string& prefix, std::string_view query);
+
+public:
+    FuzzySession(const std::vector<std::string_view>& items);
+
+    // returns the best `limit` matches for `query` (all if `limit` is 0),
+    // ordered from best to worst; `total` receives the number of matches
+    std::vector<FuzzyMatch> filter(std::string_view query, size_t limit, size_t& total);
+
+    size_t size() const;
+    std::string_view getItem(size_t idx) const;
+};
@@ -0,0 +1,479 @@
+#include "SymbolHarvester.h"
+#include "FuzzyMatcher.h"
+#include "../project/DirReader.h"
+#include "../scheduler/Wakeup.h"
+
+#include <string.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#define PATHSEP '\\'
+#else
+#define PATHSEP '/'
+#endif
+
+#define SYMBOLS_MAGIC "LXTSYM02"
+
+// symbols shorter than this are never worth completing
+#define MIN_SYMBOL_LENGTH 3
+
+// keywords which introduce a definition, in the languages that have them
+static const std::unordered_set<std::string_view> definitionKeywords =
+{
+    "function", "def", "class", "struct", "enum", "union", "interface",
+    "namespace", "trait", "fn", "func"
+};
+
+
+#pragma region HELPER FUNCTIONS
+template <typename T>
+static void writeValue(std::ofstream& file, T value)
+{
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+static void writeString(std::ofstream& file, std::string_view str)
+{
+    writeValue<uint32_t>(file, static_cast<uint32_t>(str.size()));
+    file.write(str.data(), str.size());
+}
+
+template <typename T>
+static bool readValue(std::ifstream& file, T& value)
+{
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+static bool readString(std::ifstream& file, std::string& str)
+{
+    uint32_t len;
+    if (!readValue(file, len) || len > (1u << 20)) return false;
+    str.resize(len);
+    return static_cast<bool>(file.read(&str[0], len));
+}
+
+static bool isSymbolStart(unsigned char c)
+{
+    return c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static bool isSymbolPart(unsigned char c)
+{
+    return isSymbolStart(c) || (c >= '0' && c <= '9');
+}
+#pragma endregion
+
+
+SymbolHarvester::SymbolHarvester(const std::string& root, const std::vector<HarvestLanguage>& languages,
+    const std::string& cacheFile, uint64_t sizeLimit)
+    : root(root), cacheFile(cacheFile), sizeLimit(sizeLimit), languages(languages), nextFileId(0),
+    definitionsDirty(true), cacheDirty(false), stopping(false)
+{
+    for (size_t i = 0; i < this->languages.size(); i++)
+    {
+        for (auto& ext : this->languages[i].extensions) extensionLanguages[ext] = i;
+    }
+
+    if (!cacheFile.empty()) load();
+    Wakeup::getEventType();
+
+    // leave a core for the UI thread
+    auto count = std::max(1u, std::thread::hardware_concurrency() / 2);
+    for (unsigned i = 0; i < count; i++)
+    {
+        workers.emplace_back(&SymbolHarvester::run, this);
+    }
+}
+
+SymbolHarvester::~SymbolHarvester()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void SymbolHarvester::update(const ProjectTree& tree)
+{
+    std::unordered_set<std::string> present;
+    std::vector<Job> newJobs;
+
+    for (size_t i = 0; i < tree.size(); i++)
+    {
+        auto& node = tree.getNode(i);
+        if (node.isDir) continue;
+
+        auto& name = tree.getName(i);
+        auto dot = name.rfind('.');
+        if (dot == std::string::npos) continue;
+        auto lang = extensionLanguages.find(name.substr(dot + 1));
+        if (lang == extensionLanguages.end()) continue;
+
+        auto relPath = tree.getRelativePath(i, PATHSEP);
+        FileStamp stamp{ node.modified, node.size };
+        auto file = files.find(relPath);
+        auto pending = queued.find(relPath);
+        if ((file == files.end() || file->second.stamp != stamp) &&
+            (pending == queued.end() || pending->second != stamp))
+        {
+            queued[relPath] = stamp;
+            newJobs.push_back({ relPath, stamp, lang->second });
+        }
+        present.insert(std::move(relPath));
+    }
+
+    // forget files which were deleted or are now ignored
+    for (auto it = files.begin(); it != files.end(); )
+    {
+        if (present.count(it->first))
+        {
+            ++it;
+            continue;
+        }
+        index.removeDoc(it->second.id);
+        it = files.erase(it);
+        definitionsDirty = cacheDirty = true;
+    }
+
+    // files which left the tree before they were harvested would keep the
+    // harvester busy, and hold back the cache save, forever
+    bool pruned = false;
+    for (auto it = queued.begin(); it != queued.end(); )
+    {
+        if (present.count(it->first))
+        {
+            ++it;
+            continue;
+        }
+        it = queued.erase(it);
+        pruned = true;
+    }
+
+    if (newJobs.empty() && !pruned) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pruned)
+        {
+            jobs.erase(std::remove_if(jobs.begin(), jobs.end(),
+                [&](const Job& job) { return !present.count(job.relPath); }), jobs.end());
+        }
+        jobs.insert(jobs.end(), std::make_move_iterator(newJobs.begin()), std::make_move_iterator(newJobs.end()));
+    }
+    if (!newJobs.empty()) condition.notify_all();
+}
+
+void SymbolHarvester::run()
+{
+    DirReader::lowerThreadPriority();
+
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping) return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        auto result = harvest(job);
+
+        bool first;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            first = results.empty();
+            results.push_back(std::move(result));
+        }
+        // one wakeup until the results are polled again
+        if (first) Wakeup::post();
+    }
+}
+
+SymbolHarvester::Result SymbolHarvester::harvest(const Job& job) const
+{
+    Result result;
+    result.relPath = job.relPath;
+    result.stamp = job.stamp;
+
+    auto file = std::ifstream(root + PATHSEP + job.relPath, std::ios::in | std::ios::binary);
+    if (!file.is_open()) return result;
+
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if ((sizeLimit && text.size() >= sizeLimit) || memchr(text.data(), 0, std::min<size_t>(text.size(), 4096)))
+        return result;
+
+    auto& language = languages[job.language];
+    std::unordered_set<std::string_view> seen;
+    std::string_view rest(text);
+    uint32_t lineNumber = 1;
+    while (!rest.empty())
+    {
+        auto end = rest.find('\n');
+        harvestLine(rest.substr(0, end), lineNumber++, language, seen, result);
+        if (end == std::string_view::npos) break;
+        rest = rest.substr(end + 1);
+    }
+    return result;
+}
+
+void SymbolHarvester::harvestLine(std::string_view line, uint32_t lineNumber, const HarvestLanguage& language,
+    std::unordered_set<std::string_view>& seen, Result& result) const
+{
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+    // a line starting at column 0 with two or more words before its first
+    // parenthesis, such as `static int foo(`, looks like a C-style function
+    // definition unless it ends with a semicolon
+    bool topLevel = !line.empty() && isSymbolStart(line[0]) && line.back() != ';';
+    bool afterKeyword = false;
+    bool defined = false;
+    int wordsBeforeParen = 0;
+    std::string_view lastWord;
+
+    size_t i = 0;
+    while (i < line.size())
+    {
+        auto c = line[i];
+        if (!language.comment.empty() && line.compare(i, language.comment.size(), language.comment) == 0)
+            break;
+
+        if (c == '"' || c == '\'' || c == '`')
+        {
+            // skip string literals on the same line
+            for (i++; i < line.size() && line[i] != c; i++)
+            {
+                if (line[i] == '\\') i++;
+            }
+            i++;
+            lastWord = {};
+            continue;
+        }
+
+        if (!isSymbolStart(c))
+        {
+            if (c == '(' && topLevel && !defined && wordsBeforeParen >= 2 && !lastWord.empty())
+            {
+                result.definitions.push_back({ std::string(lastWord), lineNumber });
+                defined = true;
+            }
+            // only declarator punctuation may come before the parenthesis
+            if (!strchr(" \t*&:<>,", c)) topLevel = false;
+            if (c != ' ' && c != '\t') lastWord = {};
+            i++;
+            continue;
+        }
+
+        auto start = i;
+        while (i < line.size() && isSymbolPart(line[i])) i++;
+        auto word = line.substr(start, i - start);
+        wordsBeforeParen++;
+
+        if (language.keywords.count(word))
+        {
+            afterKeyword = afterKeyword || definitionKeywords.count(word);
+            lastWord = {};
+            continue;
+        }
+        lastWord = word;
+
+        // `function a.b:c` defines the last name of the chain
+        bool chained = i + 1 < line.size() && (line[i] == '.' || line[i] == ':') && isSymbolStart(line[i + 1]);
+        if (afterKeyword && !chained && !defined)
+        {
+            result.definitions.push_back({ std::string(word), lineNumber });
+            defined = true;
+        }
+        if (!chained) afterKeyword = false;
+
+        if (word.size() >= MIN_SYMBOL_LENGTH && seen.insert(word).second)
+        {
+            result.symbols.emplace_back(word);
+        }
+    }
+}
+
+size_t SymbolHarvester::poll(size_t limit)
+{
+    std::deque<Result> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (limit == 0 || results.size() <= limit)
+        {
+            finished.swap(results);
+        }
+        else
+        {
+            auto last = results.begin() + limit;
+            finished.assign(std::make_move_iterator(results.begin()), std::make_move_iterator(last));
+            results.erase(results.begin(), last);
+        }
+    }
+
+    for (auto& result : finished)
+    {
+        // a result is stale if its file left the tree or changed again
+        // since it was queued; the newer job replaces it
+        auto pending = queued.find(result.relPath);
+        if (pending == queued.end() || pending->second != result.stamp) continue;
+        queued.erase(pending);
+        apply(std::move(result));
+    }
+
+    // save once everything queued so far is in
+    if (cacheDirty && queued.empty() && !cacheFile.empty())
+    {
+        save();
+        cacheDirty = false;
+    }
+    return finished.size();
+}
+
+void SymbolHarvester::apply(Result&& result)
+{
+    auto it = files.find(result.relPath);
+    if (it == files.end())
+    {
+        it = files.emplace(result.relPath, FileSymbols{ nextFileId++, {}, {} }).first;
+    }
+
+    std::vector<std::string_view> symbols(result.symbols.begin(), result.symbols.end());
+    index.setSymbols(it->second.id, symbols);
+    it->second.stamp = result.stamp;
+    it->second.definitions = std::move(result.definitions);
+    definitionsDirty = cacheDirty = true;
+}
+
+bool SymbolHarvester::isIdle() const
+{
+    return queued.empty();
+}
+
+bool SymbolHarvester::hasResults()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return !results.empty();
+}
+
+std::vector<std::string_view> SymbolHarvester::complete(std::string_view prefix, size_t limit) const
+{
+    return index.complete(prefix, limit);
+}
+
+void SymbolHarvester::updateDefinitions()
+{
+    definitions.clear();
+    definitionNames.clear();
+    for (auto& [relPath, file] : files)
+    {
+        for (auto& definition : file.definitions)
+        {
+            definitions.push_back({ &relPath, &definition });
+            definitionNames.push_back(definition.name);
+        }
+    }
+    definitionsDirty = false;
+}
+
+std::vector<DefinitionMatch> SymbolHarvester::findDefinitions(std::string_view query, size_t limit)
+{
+    if (definitionsDirty) updateDefinitions();
+
+    std::vector<DefinitionMatch> matches;
+    for (auto& match : FuzzyMatcher::matchList(definitionNames, query, limit))
+    {
+        matches.push_back(definitions[match.index]);
+    }
+    return matches;
+}
+
+size_t SymbolHarvester::getFileCount() const
+{
+    return files.size();
+}
+
+bool SymbolHarvester::load()
+{
+    auto file = std::ifstream(cacheFile, std::ios::in | std::ios::binary);
+    if (!file.is_open()) return false;
+
+    char magic[8];
+    if (!file.read(magic, sizeof(magic)) || memcmp(magic, SYMBOLS_MAGIC, sizeof(magic)) != 0)
+        return false;
+
+    std::string fileRoot;
+    uint32_t fileCount;
+    if (!readString(file, fileRoot) || fileRoot != root || !readValue(file, fileCount))
+        return false;
+
+    std::vector<Result> loaded(fileCount);
+    for (auto& result : loaded)
+    {
+        uint32_t symbolCount, definitionCount;
+        if (!readString(file, result.relPath) || !readValue(file, result.stamp.modified) ||
+            !readValue(file, result.stamp.size) || !readValue(file, symbolCount))
+            return false;
+
+        result.symbols.resize(symbolCount);
+        for (auto& symbol : result.symbols)
+        {
+            if (!readString(file, symbol)) return false;
+        }
+
+        if (!readValue(file, definitionCount)) return false;
+        result.definitions.resize(definitionCount);
+        for (auto& definition : result.definitions)
+        {
+            if (!readString(file, definition.name) || !readValue(file, definition.line)) return false;
+        }
+    }
+
+    for (auto& result : loaded) apply(std::move(result));
+    cacheDirty = false;
+    return true;
+}
+
+bool SymbolHarvester::save() const
+{
+    std::error_code ec;
+    auto parent = std::filesystem::path(cacheFile).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent, ec);
+
+    auto tempName = cacheFile + ".tmp";
+    {
+        auto file = std::ofstream(tempName, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+
+        file.write(SYMBOLS_MAGIC, 8);
+        writeString(file, root);
+        writeValue<uint32_t>(file, static_cast<uint32_t>(files.size()));
+
+        for (auto& [relPath, symbols] : files)
+        {
+            writeString(file, relPath);
+            writeValue<int64_t>(file, symbols.stamp.modified);
+            writeValue<uint64_t>(file, symbols.stamp.size);
+
+            auto names = index.getSymbols(symbols.id);
+            writeValue<uint32_t>(file, static_cast<uint32_t>(names.size()));
+            for (auto name : names) writeString(file, name);
+
+            writeValue<uint32_t>(file, static_cast<uint32_t>(symbols.definitions.size()));
+            for (auto& definition : symbols.definitions)
+            {
+                writeString(file, definition.name);
+                writeValue<uint32_t>(file, definition.line);
+            }
+        }
+
+        if (!file.good()) return false;
+    }
+
+    std::filesystem::rename(tempName, cacheFile, ec);
+    return !ec;
+}
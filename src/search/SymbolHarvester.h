@@ -0,0 +1,137 @@
+#pragma once
+
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "SymbolIndex.h"
+#include "../project/ProjectTree.h"
+
+// What the harvester needs to know about one syntax: the file extensions
+// it applies to, the words which are never symbols, and its line comment.
+struct HarvestLanguage
+{
+    std::vector<std::string> extensions;
+    // ordered with a transparent comparator so words are looked up
+    // without copying them
+    std::set<std::string, std::less<>> keywords;
+    std::string comment;
+};
+
+struct SymbolDefinition
+{
+    std::string name;
+    uint32_t line;
+};
+
+struct DefinitionMatch
+{
+    const std::string* fileName;
+    const SymbolDefinition* definition;
+};
+
+// Collects the symbols and likely definitions of every source file in a
+// project on background threads. Results are applied on the calling
+// thread by `poll`, so queries never wait for the workers, and are saved
+// to a cache file so the next session only rereads files which changed.
+class SymbolHarvester
+{
+private:
+    // a file is harvested again when either changes; a file saved twice
+    // within a second keeps its mtime but rarely its size
+    struct FileStamp
+    {
+        int64_t modified;
+        uint64_t size;
+
+        bool operator==(const FileStamp& other) const { return modified == other.modified && size == other.size; }
+        bool operator!=(const FileStamp& other) const { return !(*this == other); }
+    };
+
+    struct FileSymbols
+    {
+        int id;
+        FileStamp stamp;
+        std::vector<SymbolDefinition> definitions;
+    };
+
+    struct Job
+    {
+        std::string relPath;
+        FileStamp stamp;
+        size_t language;
+    };
+
+    struct Result
+    {
+        std::string relPath;
+        FileStamp stamp;
+        std::vector<std::string> symbols;
+        std::vector<SymbolDefinition> definitions;
+    };
+
+    std::string root;
+    std::string cacheFile;
+    uint64_t sizeLimit;
+    std::vector<HarvestLanguage> languages;
+    std::unordered_map<std::string, size_t> extensionLanguages;
+
+    // only touched by the thread which owns the harvester
+    std::unordered_map<std::string, FileSymbols> files;
+    std::unordered_map<std::string, FileStamp> queued;
+    int nextFileId;
+    SymbolIndex index;
+    std::vector<DefinitionMatch> definitions;
+    std::vector<std::string_view> definitionNames;
+    bool definitionsDirty;
+    bool cacheDirty;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<Job> jobs;
+    std::deque<Result> results;
+    bool stopping;
+    std::vector<std::thread> workers;
+
+    void run();
+    Result harvest(const Job& job) const;
+    void harvestLine(std::string_view line, uint32_t lineNumber, const HarvestLanguage& language,
+        std::unordered_set<std::string_view>& seen, Result& result) const;
+    void apply(Result&& result);
+    void updateDefinitions();
+    bool load();
+    bool save() const;
+
+public:
+    SymbolHarvester(const std::string& root, const std::vector<HarvestLanguage>& languages,
+        const std::string& cacheFile, uint64_t sizeLimit);
+    ~SymbolHarvester();
+
+    // queues the files of `tree` which are new or changed since they were
+    // last harvested, and forgets files which are gone
+    void update(const ProjectTree& tree);
+
+    // applies up to `limit` finished files (all if 0); returns how many
+    // were applied
+    size_t poll(size_t limit);
+    bool isIdle() const;
+
+    // true if finished files wait for `poll`; the workers post a wakeup
+    // when the first one arrives
+    bool hasResults();
+
+    std::vector<std::string_view> complete(std::string_view prefix, size_t limit) const;
+
+    // the best `limit` definitions whose names fuzzy match `query`
+    std::vector<DefinitionMatch> findDefinitions(std::string_view query, size_t limit);
+
+    size_t getFileCount() const;
+};
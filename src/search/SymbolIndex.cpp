@@ -0,0 +1,214 @@
+#include "SymbolIndex.h"
+
+#include <algorithm>
+
+
+static uint8_t lower(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : static_cast<uint8_t>(c);
+}
+
+SymbolIndex::SymbolIndex()
+{
+    nodes.emplace_back();
+    nodes[0].live = 0;
+}
+
+uint32_t SymbolIndex::intern(std::string_view text)
+{
+    auto it = symbolIds.find(text);
+    if (it != symbolIds.end()) return it->second;
+
+    // walk down the trie, adding nodes for the missing characters
+    uint32_t node = 0;
+    for (auto c : text)
+    {
+        auto key = lower(c);
+        auto& children = nodes[node].children;
+        auto child = std::lower_bound(children.begin(), children.end(), std::make_pair(key, uint32_t(0)));
+        if (child != children.end() && child->first == key)
+        {
+            node = child->second;
+            continue;
+        }
+
+        auto next = static_cast<uint32_t>(nodes.size());
+        children.insert(child, { key, next });
+        nodes.emplace_back();
+        nodes.back().live = 0;
+        node = next;
+    }
+
+    auto id = static_cast<uint32_t>(symbols.size());
+    storage.emplace_back(text);
+    symbols.push_back({ storage.back(), 0, node });
+    symbolIds.emplace(storage.back(), id);
+    nodes[node].symbols.push_back(id);
+    return id;
+}
+
+int64_t SymbolIndex::findNode(std::string_view prefix) const
+{
+    uint32_t node = 0;
+    for (auto c : prefix)
+    {
+        auto key = lower(c);
+        auto& children = nodes[node].children;
+        auto child = std::lower_bound(children.begin(), children.end(), std::make_pair(key, uint32_t(0)));
+        if (child == children.end() || child->first != key) return -1;
+        node = child->second;
+    }
+    return node;
+}
+
+void SymbolIndex::updateLive(uint32_t symbol, int delta)
+{
+    auto& text = symbols[symbol].text;
+    uint32_t node = 0;
+    nodes[node].live += delta;
+    for (auto c : text)
+    {
+        auto key = lower(c);
+        auto& children = nodes[node].children;
+        node = std::lower_bound(children.begin(), children.end(), std::make_pair(key, uint32_t(0)))->second;
+        nodes[node].live += delta;
+    }
+}
+
+void SymbolIndex::addRef(uint32_t symbol)
+{
+    if (symbols[symbol].refs++ == 0) updateLive(symbol, 1);
+}
+
+void SymbolIndex::release(uint32_t symbol)
+{
+    if (--symbols[symbol].refs == 0) updateLive(symbol, -1);
+}
+
+void SymbolIndex::splice(int doc, size_t line, size_t removed, const std::vector<std::string_view>& added)
+{
+    std::vector<std::vector<uint32_t>> newLines(added.size());
+    for (size_t i = 0; i < added.size(); i++)
+    {
+        scanLine(added[i], [&](std::string_view text)
+        {
+            auto symbol = intern(text);
+            addRef(symbol);
+            newLines[i].push_back(symbol);
+        });
+    }
+    replaceLines(doc, line, removed, newLines);
+}
+
+void SymbolIndex::spliceSymbols(int doc, size_t line, size_t removed, const std::vector<std::vector<std::string_view>>& added)
+{
+    std::vector<std::vector<uint32_t>> newLines(added.size());
+    for (size_t i = 0; i < added.size(); i++)
+    {
+        newLines[i].reserve(added[i].size());
+        for (auto text : added[i])
+        {
+            auto symbol = intern(text);
+            addRef(symbol);
+            newLines[i].push_back(symbol);
+        }
+    }
+    replaceLines(doc, line, removed, newLines);
+}
+
+void SymbolIndex::replaceLines(int doc, size_t line, size_t removed, std::vector<std::vector<uint32_t>>& newLines)
+{
+    // the new symbols were referenced first, so ones moving between lines
+    // never drop out of the trie
+    auto& lines = docs[doc];
+    line = std::min(line, lines.size());
+    removed = std::min(removed, lines.size() - line);
+
+    for (size_t i = line; i < line + removed; i++)
+    {
+        for (auto symbol : lines[i]) release(symbol);
+    }
+
+    // reuse the removed slots where possible rather than shifting twice
+    auto common = std::min(removed, newLines.size());
+    std::move(newLines.begin(), newLines.begin() + common, lines.begin() + line);
+    if (removed > common)
+    {
+        lines.erase(lines.begin() + line + common, lines.begin() + line + removed);
+    }
+    else
+    {
+        lines.insert(lines.begin() + line + common,
+            std::make_move_iterator(newLines.begin() + common), std::make_move_iterator(newLines.end()));
+    }
+}
+
+void SymbolIndex::setSymbols(int doc, const std::vector<std::string_view>& symbols)
+{
+    removeDoc(doc);
+    auto& lines = docs[doc];
+    lines.emplace_back();
+    lines[0].reserve(symbols.size());
+    for (auto text : symbols)
+    {
+        auto symbol = intern(text);
+        addRef(symbol);
+        lines[0].push_back(symbol);
+    }
+}
+
+std::vector<std::string_view> SymbolIndex::getSymbols(int doc) const
+{
+    std::vector<std::string_view> result;
+    auto it = docs.find(doc);
+    if (it == docs.end()) return result;
+
+    for (auto& line : it->second)
+    {
+        for (auto symbol : line) result.push_back(symbols[symbol].text);
+    }
+    return result;
+}
+
+void SymbolIndex::removeDoc(int doc)
+{
+    auto it = docs.find(doc);
+    if (it == docs.end()) return;
+
+    for (auto& line : it->second)
+    {
+        for (auto symbol : line) release(symbol);
+    }
+    docs.erase(it);
+}
+
+void SymbolIndex::collect(uint32_t node, size_t limit, std::vector<std::string_view>& results) const
+{
+    auto& n = nodes[node];
+    for (auto symbol : n.symbols)
+    {
+        if (results.size() >= limit) return;
+        if (symbols[symbol].refs > 0) results.push_back(symbols[symbol].text);
+    }
+
+    // subtrees without live symbols are skipped, so the walk stays bounded
+    // by the number of results rather than the number of symbols
+    for (auto& child : n.children)
+    {
+        if (results.size() >= limit) return;
+        if (nodes[child.second].live > 0) collect(child.second, limit, results);
+    }
+}
+
+std::vector<std::string_view> SymbolIndex::complete(std::string_view prefix, size_t limit) const
+{
+    std::vector<std::string_view> results;
+    auto node = findNode(prefix);
+    if (node >= 0 && limit > 0) collect(static_cast<uint32_t>(node), limit, results);
+    return results;
+}
+
+size_t SymbolIndex::size() const
+{
+    return nodes[0].live;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Symbols of the open documents, kept up to date one edited line range at
+// a time. Every symbol carries a reference count over all documents, and a
+// case-insensitive prefix trie over the live symbols answers completion
+// queries without looking at the documents.
+class SymbolIndex
+{
+private:
+    struct Symbol
+    {
+        std::string_view text;
+        uint32_t refs;
+        uint32_t node;
+    };
+
+    struct TrieNode
+    {
+        std::vector<std::pair<uint8_t, uint32_t>> children;
+        std::vector<uint32_t> symbols;
+        uint32_t live;
+    };
+
+    std::deque<std::string> storage;
+    std::unordered_map<std::string_view, uint32_t> symbolIds;
+    std::vector<Symbol> symbols;
+    std::vector<TrieNode> nodes;
+
+    // symbol ids found on each line of each document
+    std::unordered_map<int, std::vector<std::vector<uint32_t>>> docs;
+
+    uint32_t intern(std::string_view text);
+    int64_t findNode(std::string_view prefix) const;
+    void addRef(uint32_t symbol);
+    void release(uint32_t symbol);
+    void updateLive(uint32_t symbol, int delta);
+    void collect(uint32_t node, size_t limit, std::vector<std::string_view>& results) const;
+    void replaceLines(int doc, size_t line, size_t removed, std::vector<std::vector<uint32_t>>& newLines);
+
+public:
+    SymbolIndex();
+
+    // calls `fn` with every identifier in `line`
+    template <typename F>
+    static void scanLine(std::string_view line, F fn);
+
+    // replaces `removed` lines of a document starting at `line` (0-based)
+    // with `added`; unknown documents are created empty
+    void splice(int doc, size_t line, size_t removed, const std::vector<std::string_view>& added);
+
+    // same as splice, with each added line's symbols found by the caller,
+    // for symbol patterns scanLine does not implement
+    void spliceSymbols(int doc, size_t line, size_t removed, const std::vector<std::vector<std::string_view>>& added);
+
+    // replaces a document with symbols collected elsewhere
+    void setSymbols(int doc, const std::vector<std::string_view>& symbols);
+    std::vector<std::string_view> getSymbols(int doc) const;
+    void removeDoc(int doc);
+
+    // up to `limit` live symbols starting with `prefix`, ignoring case, in
+    // alphabetical order
+    std::vector<std::string_view> complete(std::string_view prefix, size_t limit) const;
+
+    size_t size() const;
+};
+
+template <typename F>
+void SymbolIndex::scanLine(std::string_view line, F fn)
+{
+    // identifiers as matched by the default symbol pattern, [%a_][%w_]*
+    auto isStart = [](unsigned char c) { return c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); };
+    auto isPart = [&](unsigned char c) { return isStart(c) || (c >= '0' && c <= '9'); };
+
+    size_t i = 0;
+    while (i < line.size())
+    {
+        if (!isStart(line[i]))
+        {
+            i++;
+            continue;
+        }
+        auto start = i;
+        while (i < line.size() && isPart(line[i])) i++;
+        fn(line.substr(start, i - start));
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+// Unbounded lock-free queue for exactly one producer thread and one
+// consumer thread. The consumer owns the head (a dummy node) and the
+// producer owns the tail; they only meet through the atomic `next` links.
+template <typename T>
+class MessageQueue
+{
+private:
+    struct Node
+    {
+        T value;
+        std::atomic<Node*> next;
+
+        Node() : next(nullptr) {}
+        Node(T&& value) : value(std::move(value)), next(nullptr) {}
+    };
+
+    Node* head;
+    Node* tail;
+
+public:
+    MessageQueue() : head(new Node()), tail(head) {}
+
+    ~MessageQueue()
+    {
+        while (head)
+        {
+            auto next = head->next.load(std::memory_order_relaxed);
+            delete head;
+            head = next;
+        }
+    }
+
+    MessageQueue(const MessageQueue&) = delete;
+    MessageQueue& operator=(const MessageQueue&) = delete;
+
+    // producer only
+    void push(T value)
+    {
+        auto node = new Node(std::move(value));
+        tail->next.store(node, std::memory_order_release);
+        tail = node;
+    }
+
+    // consumer only
+    bool empty() const
+    {
+        return head->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+    // consumer only; returns false if the queue is empty
+    bool pop(T& value)
+    {
+        auto next = head->next.load(std::memory_order_acquire);
+        if (!next) return false;
+
+        value = std::move(next->value);
+        delete head;
+        head = next;
+        return true;
+    }
+};
@@ -0,0 +1,223 @@
+#include "Worker.h"
+
+#include <chrono>
+#include <SDL.h>
+
+std::unordered_map<uint32_t, Worker*> Worker::workers;
+uint32_t Worker::nextId = 1;
+uint32_t Worker::eventType = 0;
+
+
+Worker::Worker(const std::string& module, std::vector<WorkerValue>&& args, const WorkerEnvironment& environment)
+    : id(nextId++), module(module), args(std::move(args)), environment(environment), stopping(false), running(true),
+    notified(false), abandoned(false)
+{
+    getEventType();
+    workers[id] = this;
+    thread = std::thread(&Worker::run, this);
+}
+
+Worker::~Worker()
+{
+    abandoned = true;
+    stop();
+    thread.join();
+    workers.erase(id);
+}
+
+uint32_t Worker::getId() const
+{
+    return id;
+}
+
+bool Worker::isRunning() const
+{
+    return running;
+}
+
+void Worker::send(std::vector<WorkerValue>&& values)
+{
+    inbox.push(std::move(values));
+
+    // taking the lock makes sure a worker about to sleep sees the message
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    wake.notify_one();
+}
+
+bool Worker::receive(WorkerMessage& message)
+{
+    // clearing the flag first means a message pushed from here on either
+    // announces itself or is seen below
+    notified = false;
+    if (!outbox.pop(message)) return false;
+
+    // the event just handled freed a slot in SDL's queue, so this is
+    // unlikely to fail; if it does the worker's next message retries
+    if (!outbox.empty()) notify();
+    return true;
+}
+
+bool Worker::notify()
+{
+    if (notified.exchange(true)) return true;
+
+    SDL_Event e;
+    SDL_zero(e);
+    e.type = eventType;
+    e.user.code = static_cast<Sint32>(id);
+    if (SDL_PushEvent(&e) > 0) return true;
+
+    notified = false;
+    return false;
+}
+
+void Worker::stop()
+{
+    stopping = true;
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    wake.notify_one();
+}
+
+Worker* Worker::find(uint32_t id)
+{
+    auto it = workers.find(id);
+    return it == workers.end() ? nullptr : it->second;
+}
+
+uint32_t Worker::getEventType()
+{
+    if (eventType == 0) eventType = SDL_RegisterEvents(1);
+    return eventType;
+}
+
+
+#pragma region WORKER STATE
+static Worker* get_worker(lua_State* L)
+{
+    return reinterpret_cast<Worker*>(lua_touserdata(L, lua_upvalueindex(1)));
+}
+
+// worker.send(...): copies the values to the main state
+int Worker::f_send(lua_State* L)
+{
+    auto self = get_worker(L);
+    WorkerMessage message;
+    std::string error;
+    if (!WorkerValue::fromLuaArgs(L, 1, message.values, error)) return luaL_error(L, "%s", error.c_str());
+
+    // if SDL's queue is full the message waits for the next announcement
+    self->outbox.push(std::move(message));
+    self->notify();
+    return 0;
+}
+
+// worker.receive([timeout]): returns the values of the next message, or
+// nothing if the timeout passed or the worker is being stopped
+int Worker::f_receive(lua_State* L)
+{
+    auto self = get_worker(L);
+    std::vector<WorkerValue> values;
+    bool received = false;
+    auto ready = [&] { return self->stopping || (received = self->inbox.pop(values)); };
+
+    {
+        std::unique_lock<std::mutex> lock(self->wakeMutex);
+        if (lua_isnoneornil(L, 1))
+        {
+            self->wake.wait(lock, ready);
+        }
+        else
+        {
+            auto timeout = std::chrono::duration<double>(luaL_checknumber(L, 1));
+            self->wake.wait_for(lock, timeout, ready);
+        }
+    }
+    if (!received) return 0;
+
+    luaL_checkstack(L, static_cast<int>(values.size()), "too many values");
+    for (auto& value : values) value.push(L);
+    return static_cast<int>(values.size());
+}
+
+int Worker::f_is_stopping(lua_State* L)
+{
+    lua_pushboolean(L, get_worker(L)->stopping);
+    return 1;
+}
+
+void Worker::openWorkerLib(lua_State* L)
+{
+    const luaL_Reg lib[] =
+    {
+        { "send",           f_send          },
+        { "receive",        f_receive       },
+        { "is_stopping",    f_is_stopping   },
+        { NULL,             NULL            }
+    };
+
+    lua_newtable(L);
+    for (auto fn = lib; fn->func; fn++)
+    {
+        lua_pushlightuserdata(L, this);
+        lua_pushcclosure(L, fn->func, 1);
+        lua_setfield(L, -2, fn->name);
+    }
+    lua_pushnumber(L, id);
+    lua_setfield(L, -2, "id");
+    lua_setglobal(L, "worker");
+}
+#pragma endregion
+
+
+void Worker::run()
+{
+    lua_State* L = luaL_newstate();
+    luaL_openlibs(L);
+    openWorkerLib(L);
+
+    lua_getglobal(L, "package");
+    lua_pushstring(L, environment.packagePath.c_str());
+    lua_setfield(L, -2, "path");
+    lua_pushstring(L, environment.packageCPath.c_str());
+    lua_setfield(L, -2, "cpath");
+    lua_getfield(L, -1, "config");
+    lua_pushlstring(L, lua_tostring(L, -1), 1);
+    lua_setglobal(L, "PATHSEP");
+    lua_pop(L, 2);
+
+    lua_pushstring(L, environment.exeDir.c_str());
+    lua_setglobal(L, "EXEDIR");
+    lua_pushstring(L, SDL_GetPlatform());
+    lua_setglobal(L, "PLATFORM");
+
+    // the module returns the function the worker runs
+    WorkerMessage done;
+    done.done = true;
+    lua_getglobal(L, "require");
+    lua_pushstring(L, module.c_str());
+    int base = lua_gettop(L) - 2;
+    done.ok = lua_pcall(L, 1, 1, 0) == 0;
+    if (done.ok)
+    {
+        luaL_checkstack(L, static_cast<int>(args.size()), "too many arguments");
+        for (auto& arg : args) arg.push(L);
+        done.ok = lua_pcall(L, static_cast<int>(args.size()), LUA_MULTRET, 0) == 0;
+    }
+
+    std::string error;
+    if (!WorkerValue::fromLuaArgs(L, base + 1, done.values, error))
+    {
+        done.ok = false;
+        done.values.assign(1, WorkerValue());
+        done.values[0].type = WorkerValue::Type::String;
+        done.values[0].string = error;
+    }
+    lua_close(L);
+
+    running = false;
+    outbox.push(std::move(done));
+
+    // nothing else will announce the last message, so keep trying until
+    // the main thread has room for it or no longer wants it
+    while (!notify() && !abandoned) SDL_Delay(10);
+}
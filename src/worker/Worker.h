@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "MessageQueue.h"
+#include "WorkerValue.h"
+
+struct WorkerMessage
+{
+    // set on the last message a worker sends, once its function returned
+    bool done = false;
+    bool ok = true;
+    std::vector<WorkerValue> values;
+};
+
+// What a worker's fresh Lua state copies from the main state.
+struct WorkerEnvironment
+{
+    std::string packagePath;
+    std::string packageCPath;
+    std::string exeDir;
+};
+
+// Runs a Lua module on its own OS thread with its own Lua state. The
+// worker calls the function the module returns with the spawn arguments;
+// it can exchange plain data with the main state through a `worker`
+// global. Messages for the main state are announced with an SDL event, so
+// they arrive through the normal event loop; each event delivers one
+// message and announces the next one if more are waiting.
+class Worker
+{
+private:
+    static std::unordered_map<uint32_t, Worker*> workers;
+    static uint32_t nextId;
+    static uint32_t eventType;
+
+    uint32_t id;
+    std::string module;
+    std::vector<WorkerValue> args;
+    WorkerEnvironment environment;
+
+    MessageQueue<std::vector<WorkerValue>> inbox;
+    MessageQueue<WorkerMessage> outbox;
+    std::atomic<bool> stopping;
+    std::atomic<bool> running;
+
+    // set while an event announcing the outbox is queued, so a burst of
+    // messages costs one event at a time
+    std::atomic<bool> notified;
+    std::atomic<bool> abandoned;
+
+    // only used to sleep while the inbox is empty
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+
+    std::thread thread;
+
+    void run();
+    void openWorkerLib(lua_State* L);
+    bool notify();
+
+    static int f_send(lua_State* L);
+    static int f_receive(lua_State* L);
+    static int f_is_stopping(lua_State* L);
+
+public:
+    Worker(const std::string& module, std::vector<WorkerValue>&& args, const WorkerEnvironment& environment);
+    ~Worker();
+
+    Worker(const Worker&) = delete;
+    Worker& operator=(const Worker&) = delete;
+
+    uint32_t getId() const;
+    bool isRunning() const;
+
+    // main thread side
+    void send(std::vector<WorkerValue>&& values);
+    bool receive(WorkerMessage& message);
+
+    // asks the worker to finish; `worker.receive` returns nothing from now on
+    void stop();
+
+    static Worker* find(uint32_t id);
+
+    // the SDL event type announcing worker messages; must first be called
+    // from the main thread
+    static uint32_t getEventType();
+};
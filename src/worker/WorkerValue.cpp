@@ -0,0 +1,107 @@
+#include "WorkerValue.h"
+
+// deeper tables are most likely cyclic
+#define MAX_TABLE_DEPTH 64
+
+
+bool WorkerValue::fromLua(lua_State* L, int idx, WorkerValue& value, std::string& error, int depth)
+{
+    if (idx < 0) idx = lua_gettop(L) + idx + 1;
+
+    switch (lua_type(L, idx))
+    {
+    case LUA_TNIL:
+    case LUA_TNONE:
+        value.type = Type::Nil;
+        return true;
+
+    case LUA_TBOOLEAN:
+        value.type = Type::Boolean;
+        value.boolean = lua_toboolean(L, idx) != 0;
+        return true;
+
+    case LUA_TNUMBER:
+        value.type = Type::Number;
+        value.number = lua_tonumber(L, idx);
+        return true;
+
+    case LUA_TSTRING:
+    {
+        size_t len;
+        auto str = lua_tolstring(L, idx, &len);
+        value.type = Type::String;
+        value.string.assign(str, len);
+        return true;
+    }
+
+    case LUA_TTABLE:
+        if (depth >= MAX_TABLE_DEPTH)
+        {
+            error = "table is nested too deeply (or cyclic)";
+            return false;
+        }
+        value.type = Type::Table;
+        lua_pushnil(L);
+        while (lua_next(L, idx))
+        {
+            value.keys.emplace_back();
+            value.values.emplace_back();
+            if (!fromLua(L, -2, value.keys.back(), error, depth + 1) ||
+                !fromLua(L, -1, value.values.back(), error, depth + 1))
+            {
+                lua_pop(L, 2);
+                return false;
+            }
+            lua_pop(L, 1);
+        }
+        return true;
+
+    default:
+        error = std::string("cannot copy a ") + luaL_typename(L, idx) + " to another Lua state";
+        return false;
+    }
+}
+
+bool WorkerValue::fromLuaArgs(lua_State* L, int first, std::vector<WorkerValue>& values, std::string& error)
+{
+    auto top = lua_gettop(L);
+    values.resize(top >= first ? top - first + 1 : 0);
+    for (int i = first; i <= top; i++)
+    {
+        if (!fromLua(L, i, values[i - first], error)) return false;
+    }
+    return true;
+}
+
+void WorkerValue::push(lua_State* L) const
+{
+    switch (type)
+    {
+    case Type::Boolean:
+        lua_pushboolean(L, boolean);
+        break;
+
+    case Type::Number:
+        lua_pushnumber(L, number);
+        break;
+
+    case Type::String:
+        lua_pushlstring(L, string.data(), string.size());
+        break;
+
+    case Type::Table:
+        luaL_checkstack(L, 3, "table too deep");
+        lua_createtable(L, 0, static_cast<int>(keys.size()));
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            keys[i].push(L);
+            values[i].push(L);
+            lua_rawset(L, -3);
+        }
+        break;
+
+    default:
+        lua_pushnil(L);
+        break;
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <lua.hpp>
+
+// A copy of a plain Lua value which can move between Lua states: nil,
+// booleans, numbers, strings and tables of those. Functions, userdata,
+// threads and cyclic tables cannot be copied.
+struct WorkerValue
+{
+    enum class Type : uint8_t
+    {
+        Nil,
+        Boolean,
+        Number,
+        String,
+        Table
+    };
+
+    Type type = Type::Nil;
+    bool boolean = false;
+    double number = 0;
+    std::string string;
+    std::vector<WorkerValue> keys;
+    std::vector<WorkerValue> values;
+
+    // returns false and sets `error` if the value cannot be copied
+    static bool fromLua(lua_State* L, int idx, WorkerValue& value, std::string& error, int depth = 0);
+
+    // copies the values at [first, lua_gettop(L)]
+    static bool fromLuaArgs(lua_State* L, int first, std::vector<WorkerValue>& values, std::string& error);
+
+    void push(lua_State* L) const;
+};